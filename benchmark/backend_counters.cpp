@@ -0,0 +1,230 @@
+/**	@file	Per-operation hardware counters of the module-bound allocation backends.
+
+	Runs the same workloads through every allocation mode and prints, per
+	operation (one allocation and one deallocation), the wall time and the
+	cycles, instructions, L1d/LLC/dTLB misses and page faults of the calling
+	thread.
+
+	Workloads:
+	- blocks: random sizes from 8 to 1024 bytes, freeing a random live block
+	  before each allocation (1024 live blocks)
+	- map: inserting keys into a std::map and erasing them again
+
+	The segregated slabs only serve blocks of their element's size, so the
+	segregated backend runs the map workload only.
+
+	@code
+	g++ -O2 -std=c++17 -I.. backend_counters.cpp -o backend_counters -pthread
+	./backend_counters [million operations per run, default 2]
+	@endcode
+
+	@date	2026 10 17	kj	created
+ */
+
+#include <map>
+#include <vector>
+#include <functional>	// std::less
+#include <cstdio>
+#include <cstdlib>	// std::atoi
+#include <stddef.h>
+#include "perf_counters.h"
+#include "../modulebound_allocator.h"
+#include "../modulebound_recycling.h"
+#include "../modulebound_segregated.h"
+#include "../modulebound_unsynchronized.h"
+#include "../modulebound_region.h"
+
+
+namespace
+{
+
+const size_t live_blocks = 1024;
+const size_t map_keys = 64 * 1024;
+
+
+// deterministic pseudo random numbers, the same sequence for every backend
+class xorshift
+{
+	unsigned m_nState;
+
+public:
+	xorshift() throw():
+		m_nState(2463534242u)
+	{}
+
+	unsigned operator ()() throw()
+	{
+		m_nState ^= m_nState << 13;
+		m_nState ^= m_nState >> 17;
+		m_nState ^= m_nState << 5;
+		return m_nState;
+	}
+};
+
+// mostly small blocks, as in node and string heavy code
+size_t block_size(xorshift& rRandom) throw()
+{
+	const unsigned n = rRandom();
+	return (n & 3) ? 8 + (n >> 8) % 120 : 8 + (n >> 8) % 1017;
+}
+
+
+// the allocation calls of a backend
+template<typename Allocator>
+struct plain_calls
+{
+	static char* allocate(Allocator& rAllocator, size_t n)
+	{
+		return rAllocator.allocate(n);
+	}
+
+	static void deallocate(Allocator& rAllocator, char* p, size_t n)
+	{
+		rAllocator.deallocate(p, n);
+	}
+};
+
+template<typename Allocator>
+struct hot_calls
+{
+	static char* allocate(Allocator& rAllocator, size_t n)
+	{
+		return rAllocator.allocate(n, kj::hint::hot);
+	}
+
+	static void deallocate(Allocator& rAllocator, char* p, size_t n)
+	{
+		rAllocator.deallocate(p, n, kj::hint::hot);
+	}
+};
+
+
+// the scope a backend's allocators are constructed in
+struct no_scope
+{};
+
+struct region_scope
+{
+	kj::scoped_module_region m_region;
+};
+
+
+void print_header()
+{
+	std::printf("%-16s %-7s %9s", "backend", "load", "ns/op");
+	for (int i = 0; i != kj::bench::perf_event_count; ++i)
+		std::printf(" %10s", kj::bench::perf_event_name(kj::bench::perf_event_kind(i)));
+	std::printf("\n");
+}
+
+void print_row(const char* pszBackend, const char* pszWorkload, const kj::bench::perf_sample& rSample, size_t nOps)
+{
+	std::printf("%-16s %-7s %9.2f", pszBackend, pszWorkload, rSample.m_dSeconds * 1e9 / double(nOps));
+	for (int i = 0; i != kj::bench::perf_event_count; ++i)
+	{
+		if (rSample.m_available[i])
+			std::printf(" %10.3f", double(rSample.m_values[i]) / double(nOps));
+		else
+			std::printf(" %10s", "n/a");
+	}
+	std::printf("\n");
+}
+
+
+template<typename Mode, template<typename> class Calls, typename Scope>
+void run_blocks(const char* pszBackend, size_t nOps)
+{
+	typedef kj::modulebound_allocator<char, Mode> allocator_type;
+	typedef Calls<allocator_type> calls;
+
+	Scope scope;
+	(void) scope;
+	allocator_type allocator;
+	xorshift random;
+	std::vector<char*> blocks(live_blocks);
+	std::vector<size_t> sizes(live_blocks);
+	for (size_t i = 0; i != live_blocks; ++i)
+	{
+		sizes[i] = block_size(random);
+		blocks[i] = calls::allocate(allocator, sizes[i]);
+	}
+
+	kj::bench::perf_counters counters;
+	counters.start();
+	for (size_t i = 0; i != nOps; ++i)
+	{
+		const size_t nSlot = random() % live_blocks;
+		calls::deallocate(allocator, blocks[nSlot], sizes[nSlot]);
+		sizes[nSlot] = block_size(random);
+		blocks[nSlot] = calls::allocate(allocator, sizes[nSlot]);
+		// touch the block like a user would
+		blocks[nSlot][0] = char(i);
+	}
+	const kj::bench::perf_sample sample = counters.stop();
+
+	for (size_t i = 0; i != live_blocks; ++i)
+		calls::deallocate(allocator, blocks[i], sizes[i]);
+
+	print_row(pszBackend, "blocks", sample, nOps);
+}
+
+template<typename Mode, typename Scope>
+void run_map(const char* pszBackend, size_t nOps)
+{
+	typedef std::map<unsigned, unsigned, std::less<unsigned>, kj::modulebound_allocator<std::pair<const unsigned, unsigned>, Mode> > map_type;
+
+	const size_t nRounds = (nOps + map_keys - 1) / map_keys;
+	kj::bench::perf_counters counters;
+	counters.start();
+	for (size_t nRound = 0; nRound != nRounds; ++nRound)
+	{
+		// a fresh region per round, so a region backend doesn't grow without bound
+		Scope scope;
+		(void) scope;
+		xorshift random;
+		map_type m;
+		for (size_t i = 0; i != map_keys; ++i)
+			m[random()] = unsigned(i);
+		while (!m.empty())
+			m.erase(m.begin());
+	}
+	const kj::bench::perf_sample sample = counters.stop();
+
+	print_row(pszBackend, "map", sample, nRounds * map_keys);
+}
+
+template<typename Mode>
+void run_backend(const char* pszBackend, size_t nOps)
+{
+	run_blocks<Mode, plain_calls, no_scope>(pszBackend, nOps);
+	run_map<Mode, no_scope>(pszBackend, nOps);
+}
+
+}	// namespace
+
+
+int main(int argc, char* argv[])
+{
+	const size_t nOps = size_t(argc > 1 ? std::atoi(argv[1]) : 2) * 1000 * 1000;
+
+	{
+		kj::bench::perf_counters probe;
+		if (!probe.any_available())
+			std::printf("# no hardware counters available (perf_event_paranoid, virtualization or not linux)\n");
+	}
+
+	typedef std::integral_constant<kj::raw_allocation_type, kj::raw_allocation_single> default_mode;
+
+	print_header();
+	run_backend<default_mode>("default", nOps);
+	run_blocks<default_mode, hot_calls, no_scope>("hinted-hot", nOps);
+	// the region keeps every block until its scope ends
+	run_blocks<default_mode, plain_calls, region_scope>("region", nOps / 16);
+	run_map<default_mode, region_scope>("region", nOps);
+	run_backend<kj::recycling_allocation<64> >("recycling", nOps);
+	// slabs serve only sizeof(T), mixed block sizes would all go to the heap
+	run_map<kj::segregated_allocation<>, no_scope>("segregated", nOps);
+	run_backend<kj::unsynchronized_pool_allocation<> >("unsynchronized", nOps);
+
+	return 0;
+}
@@ -0,0 +1,194 @@
+/**	@file	Hardware performance counters for the allocator benchmarks.
+
+	On Linux the counters are read with @c perf_event_open, counting the
+	calling thread in user space. Counters the kernel or the cpu doesn't
+	provide (e.g. in virtual machines, or with @c perf_event_paranoid > 2)
+	are reported as unavailable; on other systems all of them are.
+
+	@code
+	kj::bench::perf_counters counters;
+	counters.start();
+	run_workload();
+	const kj::bench::perf_sample sample = counters.stop();
+	@endcode
+
+	@date	2026 10 17	kj	created
+ */
+
+#ifndef KJ_BENCHMARK_PERF_COUNTERS_H_INCLUDED
+#define KJ_BENCHMARK_PERF_COUNTERS_H_INCLUDED
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#  pragma once
+#endif
+
+#include <chrono>
+#include <cstring>	// std::memset
+#include <stdint.h>
+#if defined(__linux__)
+#  include <linux/perf_event.h>
+#  include <sys/ioctl.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#endif
+
+
+namespace kj
+{
+
+namespace bench
+{
+
+/**	@short	The counted events
+ */
+enum perf_event_kind
+{
+	perf_cycles,
+	perf_instructions,
+	perf_l1d_misses,
+	perf_llc_misses,
+	perf_dtlb_misses,
+	perf_page_faults,
+	perf_event_count
+};
+
+///	Column title of an event
+inline
+const char* perf_event_name(perf_event_kind eKind) throw()
+{
+	static const char* const s_names[perf_event_count] =
+	{
+		"cycles", "instr", "L1d-miss", "LLC-miss", "dTLB-miss", "faults"
+	};
+	return s_names[eKind];
+}
+
+
+/**	@short	Counter values and wall time of a measurement
+ */
+struct perf_sample
+{
+	uint64_t m_values[perf_event_count];
+	bool m_available[perf_event_count];
+	double m_dSeconds;
+};
+
+
+/**	@short	Set of counters for the calling thread.
+
+	Every counter is opened on its own, so one missing event doesn't disable
+	the others; values are scaled if the kernel multiplexed the counters.
+ */
+class perf_counters
+{
+	int m_fds[perf_event_count];
+	std::chrono::steady_clock::time_point m_start;
+
+	// noncopyable
+	perf_counters(const perf_counters&);
+	perf_counters& operator =(const perf_counters&);
+
+#if defined(__linux__)
+	static int open_event(uint32_t nType, uint64_t nConfig) throw()
+	{
+		perf_event_attr attr;
+		std::memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = nType;
+		attr.config = nConfig;
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		return int(::syscall(__NR_perf_event_open, &attr, 0 /*this thread*/, -1 /*any cpu*/, -1 /*no group*/, 0));
+	}
+
+	static uint64_t cache_event(uint64_t nCache, uint64_t nResult) throw()
+	{
+		return nCache | (uint64_t(PERF_COUNT_HW_CACHE_OP_READ) << 8) | (nResult << 16);
+	}
+#endif
+
+public:
+	perf_counters() throw()
+	{
+		for (int i = 0; i != perf_event_count; ++i)
+			m_fds[i] = -1;
+
+#if defined(__linux__)
+		m_fds[perf_cycles] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+		m_fds[perf_instructions] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+		m_fds[perf_l1d_misses] = open_event(PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_RESULT_MISS));
+		m_fds[perf_llc_misses] = open_event(PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_RESULT_MISS));
+		m_fds[perf_dtlb_misses] = open_event(PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_RESULT_MISS));
+		m_fds[perf_page_faults] = open_event(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS);
+#endif
+	}
+
+	~perf_counters() throw()
+	{
+#if defined(__linux__)
+		for (int i = 0; i != perf_event_count; ++i)
+			if (m_fds[i] != -1)
+				::close(m_fds[i]);
+#endif
+	}
+
+	///	Whether at least one hardware counter could be opened
+	bool any_available() const throw()
+	{
+		// the page fault counter is a software event, available without a pmu
+		for (int i = 0; i != perf_page_faults; ++i)
+			if (m_fds[i] != -1)
+				return true;
+		return false;
+	}
+
+	///	Reset and start the counters
+	void start() throw()
+	{
+#if defined(__linux__)
+		for (int i = 0; i != perf_event_count; ++i)
+			if (m_fds[i] != -1)
+			{
+				::ioctl(m_fds[i], PERF_EVENT_IOC_RESET, 0);
+				::ioctl(m_fds[i], PERF_EVENT_IOC_ENABLE, 0);
+			}
+#endif
+		m_start = std::chrono::steady_clock::now();
+	}
+
+	///	Stop the counters and read them
+	perf_sample stop() throw()
+	{
+		perf_sample sample;
+		sample.m_dSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+
+		for (int i = 0; i != perf_event_count; ++i)
+		{
+			sample.m_values[i] = 0;
+			sample.m_available[i] = false;
+#if defined(__linux__)
+			if (m_fds[i] == -1)
+				continue;
+			::ioctl(m_fds[i], PERF_EVENT_IOC_DISABLE, 0);
+
+			// value, time enabled, time running
+			uint64_t values[3];
+			if (::read(m_fds[i], values, sizeof(values)) != ssize_t(sizeof(values)) || !values[2])
+				continue;
+			sample.m_values[i] = values[2] == values[1] ? values[0] : uint64_t(double(values[0]) * values[1] / values[2]);
+			sample.m_available[i] = true;
+#endif
+		}
+
+		return sample;
+	}
+};
+
+}	// namespace bench
+
+}	// namespace kj
+
+
+#endif	// file guard
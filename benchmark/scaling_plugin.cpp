@@ -0,0 +1,42 @@
+/**	@file	Plugin module of the scaling benchmark.
+
+	@code
+	g++ -O2 -std=c++17 -fPIC -shared -I.. scaling_plugin.cpp -o libscaling_plugin.so
+	@endcode
+
+	@date	2026 10 17	kj	created
+ */
+
+#include <new>
+#include <utility>	// std::move
+#include "scaling_plugin.h"
+
+
+namespace
+{
+
+// moving keeps the plugin's table, the default constructor captured it here
+template<typename Allocator>
+void construct_allocator(Allocator* pStorage)
+{
+	Allocator allocator;
+	::new (static_cast<void*>(pStorage)) Allocator(std::move(allocator));
+}
+
+}	// namespace
+
+
+extern "C" void kj_bench_plugin_default_allocator(kj::bench::default_node_allocator* pStorage)
+{
+	construct_allocator(pStorage);
+}
+
+extern "C" void kj_bench_plugin_recycling_allocator(kj::bench::recycling_node_allocator* pStorage)
+{
+	construct_allocator(pStorage);
+}
+
+extern "C" void kj_bench_plugin_segregated_allocator(kj::bench::segregated_node_allocator* pStorage)
+{
+	construct_allocator(pStorage);
+}
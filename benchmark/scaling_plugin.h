@@ -0,0 +1,58 @@
+/**	@file	Interface of the plugin module used by the scaling benchmark.
+
+	The plugin hands out allocators bound to its own module; the benchmark
+	frees the plugin's blocks through them on threads of the host.
+
+	@date	2026 10 17	kj	created
+ */
+
+#ifndef KJ_BENCHMARK_SCALING_PLUGIN_H_INCLUDED
+#define KJ_BENCHMARK_SCALING_PLUGIN_H_INCLUDED
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#  pragma once
+#endif
+
+#include <type_traits>
+#include "../modulebound_allocator.h"
+#include "../modulebound_recycling.h"
+#include "../modulebound_segregated.h"
+
+
+namespace kj
+{
+
+namespace bench
+{
+
+/**	@short	Block allocated by the scaling benchmark, the size of a small map node
+ */
+struct scaling_node
+{
+	char m_payload[48];
+};
+
+typedef kj::modulebound_allocator<scaling_node, std::integral_constant<kj::raw_allocation_type, kj::raw_allocation_single> > default_node_allocator;
+typedef kj::modulebound_allocator<scaling_node, kj::recycling_allocation<64> > recycling_node_allocator;
+typedef kj::modulebound_allocator<scaling_node, kj::segregated_allocation<> > segregated_node_allocator;
+
+}	// namespace bench
+
+}	// namespace kj
+
+
+/**	@short	Construct an allocator bound to the plugin at @e pStorage.
+
+	The allocator must be used in place: a copy made by the host would be
+	bound to the host.
+ */
+extern "C" void kj_bench_plugin_default_allocator(kj::bench::default_node_allocator* pStorage);
+extern "C" void kj_bench_plugin_recycling_allocator(kj::bench::recycling_node_allocator* pStorage);
+extern "C" void kj_bench_plugin_segregated_allocator(kj::bench::segregated_node_allocator* pStorage);
+
+#define KJ_BENCH_PLUGIN_DEFAULT_ALLOCATOR "kj_bench_plugin_default_allocator"
+#define KJ_BENCH_PLUGIN_RECYCLING_ALLOCATOR "kj_bench_plugin_recycling_allocator"
+#define KJ_BENCH_PLUGIN_SEGREGATED_ALLOCATOR "kj_bench_plugin_segregated_allocator"
+
+
+#endif	// file guard
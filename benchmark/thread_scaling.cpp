@@ -0,0 +1,291 @@
+/**	@file	Multi-threaded scalability of module-bound allocation.
+
+	Runs 1 to N threads allocating and freeing 48 byte blocks through the
+	module-bound allocation modes and reports the throughput per thread
+	count. Freeing patterns:
+	- local: every thread frees its own blocks
+	- remote: every thread hands its blocks in batches to the next thread,
+	  which frees them
+	- module: like remote, but the blocks are allocated by a plugin module
+	  (through allocators bound to it) and freed by the host's threads
+
+	Besides operations per second the table shows the speedup over one
+	thread and the contention, the share of linear scaling lost.
+
+	@code
+	g++ -O2 -std=c++17 -fPIC -shared -I.. scaling_plugin.cpp -o libscaling_plugin.so
+	g++ -O2 -std=c++17 -I.. thread_scaling.cpp -o thread_scaling -pthread -ldl
+	./thread_scaling [max threads, default: hardware threads] [ms per run, default 300] [plugin path, default ./libscaling_plugin.so]
+	@endcode
+
+	@date	2026 10 17	kj	created
+ */
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>	// std::atoi
+#include <new>
+#include <stdint.h>
+#include <stddef.h>
+#include <dlfcn.h>
+#include "scaling_plugin.h"
+#include "../modulebound_lockfree.h"
+
+
+namespace
+{
+
+// blocks allocated before a batch is freed or handed over
+const size_t batch_size = 256;
+// batches a thread can have in flight
+const size_t batches_per_thread = 8;
+// capacity of the hand-over rings, holds all batches of 128 threads
+const size_t ring_capacity = 1024;
+
+
+struct batch
+{
+	size_t m_nOwner;
+	kj::bench::scaling_node* m_nodes[batch_size];
+};
+
+typedef kj::detail::bounded_pointer_ring<ring_capacity> batch_ring;
+
+// per-thread state, on cache lines of its own
+struct worker_slot
+{
+	batch_ring m_inbox;
+	batch_ring m_empty;
+	alignas(kj::detail::cache_line_size) uint64_t m_nOps;
+};
+
+enum free_pattern
+{
+	free_local,
+	free_remote
+};
+
+
+template<typename Allocator>
+class scaling_run
+{
+	Allocator& m_rAllocator;
+	const size_t m_nThreads;
+	const free_pattern m_ePattern;
+	std::vector<batch> m_batches;
+	worker_slot* m_pSlots;
+	std::atomic<size_t> m_nReady;
+	std::atomic<bool> m_bGo;
+	std::atomic<bool> m_bStop;
+
+	// noncopyable
+	scaling_run(const scaling_run&);
+	scaling_run& operator =(const scaling_run&);
+
+	void fill(batch& rBatch)
+	{
+		for (size_t i = 0; i != batch_size; ++i)
+		{
+			rBatch.m_nodes[i] = m_rAllocator.allocate(1);
+			rBatch.m_nodes[i]->m_payload[0] = char(i);
+		}
+	}
+
+	void drain(batch& rBatch)
+	{
+		for (size_t i = 0; i != batch_size; ++i)
+			m_rAllocator.deallocate(rBatch.m_nodes[i], 1);
+	}
+
+	void run_local(size_t nThread)
+	{
+		worker_slot& rSlot = m_pSlots[nThread];
+		batch& rBatch = m_batches[nThread * batches_per_thread];
+		while (!m_bStop.load(std::memory_order_relaxed))
+		{
+			fill(rBatch);
+			drain(rBatch);
+			rSlot.m_nOps += batch_size;
+		}
+	}
+
+	void run_remote(size_t nThread)
+	{
+		worker_slot& rSlot = m_pSlots[nThread];
+		batch_ring& rNextInbox = m_pSlots[(nThread + 1) % m_nThreads].m_inbox;
+		while (!m_bStop.load(std::memory_order_relaxed))
+		{
+			// free what the previous thread handed over, then return the batch
+			bool bIdle = true;
+			if (batch* pBatch = static_cast<batch*>(rSlot.m_inbox.try_pop()))
+			{
+				drain(*pBatch);
+				rSlot.m_nOps += batch_size;
+				m_pSlots[pBatch->m_nOwner].m_empty.try_push(pBatch);
+				bIdle = false;
+			}
+			if (batch* pBatch = static_cast<batch*>(rSlot.m_empty.try_pop()))
+			{
+				fill(*pBatch);
+				rNextInbox.try_push(pBatch);
+				bIdle = false;
+			}
+			// all batches are in flight, let the other threads catch up
+			if (bIdle)
+				std::this_thread::yield();
+		}
+	}
+
+	void worker(size_t nThread)
+	{
+		m_nReady.fetch_add(1);
+		while (!m_bGo.load(std::memory_order_acquire))
+			std::this_thread::yield();
+
+		if (m_ePattern == free_local)
+			run_local(nThread);
+		else
+			run_remote(nThread);
+	}
+
+public:
+	scaling_run(Allocator& rAllocator, size_t nThreads, free_pattern ePattern):
+		m_rAllocator(rAllocator),
+		m_nThreads(nThreads),
+		m_ePattern(ePattern),
+		m_batches(nThreads * batches_per_thread),
+		m_pSlots(new worker_slot[nThreads]),
+		m_nReady(0),
+		m_bGo(false),
+		m_bStop(false)
+	{
+		for (size_t i = 0; i != nThreads; ++i)
+		{
+			m_pSlots[i].m_nOps = 0;
+			for (size_t j = 0; j != batches_per_thread; ++j)
+			{
+				m_batches[i * batches_per_thread + j].m_nOwner = i;
+				m_pSlots[i].m_empty.try_push(&m_batches[i * batches_per_thread + j]);
+			}
+		}
+	}
+
+	~scaling_run()
+	{
+		delete[] m_pSlots;
+	}
+
+	///	@return	operations (an allocation and its deallocation) per second
+	double run(unsigned nMilliseconds)
+	{
+		std::vector<std::thread> threads;
+		for (size_t i = 0; i != m_nThreads; ++i)
+			threads.push_back(std::thread(&scaling_run::worker, this, i));
+		while (m_nReady.load() != m_nThreads)
+			std::this_thread::yield();
+
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		m_bGo.store(true, std::memory_order_release);
+		std::this_thread::sleep_for(std::chrono::milliseconds(nMilliseconds));
+		m_bStop.store(true);
+		for (size_t i = 0; i != m_nThreads; ++i)
+			threads[i].join();
+		const double dSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		// free the batches still in flight
+		uint64_t nOps = 0;
+		for (size_t i = 0; i != m_nThreads; ++i)
+		{
+			nOps += m_pSlots[i].m_nOps;
+			while (batch* pBatch = static_cast<batch*>(m_pSlots[i].m_inbox.try_pop()))
+				drain(*pBatch);
+		}
+
+		return double(nOps) / dSeconds;
+	}
+};
+
+
+template<typename Allocator>
+void run_series(const char* pszBackend, const char* pszPattern, Allocator& rAllocator, free_pattern ePattern, size_t nMaxThreads, unsigned nMilliseconds)
+{
+	double dSingle = 0;
+	for (size_t nThreads = 1; nThreads <= nMaxThreads; nThreads = nThreads < nMaxThreads && nThreads * 2 > nMaxThreads ? nMaxThreads : nThreads * 2)
+	{
+		scaling_run<Allocator> run(rAllocator, nThreads, ePattern);
+		const double dOps = run.run(nMilliseconds);
+		if (nThreads == 1)
+			dSingle = dOps;
+
+		const double dSpeedup = dOps / dSingle;
+		std::printf("%-12s %-7s %7u %12.2f %12.2f %8.2f %9.1f%%\n",
+			pszBackend, pszPattern, unsigned(nThreads), dOps / 1e6, dOps / 1e6 / double(nThreads),
+			dSpeedup, 100.0 * (1.0 - dSpeedup / double(nThreads))
+		);
+		std::fflush(stdout);
+		if (nThreads == nMaxThreads)
+			break;
+	}
+}
+
+template<typename Allocator>
+void run_backend(const char* pszBackend, size_t nMaxThreads, unsigned nMilliseconds)
+{
+	Allocator allocator;
+	run_series(pszBackend, "local", allocator, free_local, nMaxThreads, nMilliseconds);
+	run_series(pszBackend, "remote", allocator, free_remote, nMaxThreads, nMilliseconds);
+}
+
+template<typename Allocator>
+void run_plugin_backend(const char* pszBackend, void* hPlugin, const char* pszFactory, size_t nMaxThreads, unsigned nMilliseconds)
+{
+	typedef void (*fp_factory_t)(Allocator*);
+
+	fp_factory_t pfnFactory = reinterpret_cast<fp_factory_t>(::dlsym(hPlugin, pszFactory));
+	if (!pfnFactory)
+	{
+		std::printf("# %s: %s not found in the plugin\n", pszBackend, pszFactory);
+		return;
+	}
+
+	// constructed in place by the plugin, bound to the plugin
+	typename std::aligned_storage<sizeof(Allocator), alignof(Allocator)>::type storage;
+	Allocator* pAllocator = reinterpret_cast<Allocator*>(&storage);
+	pfnFactory(pAllocator);
+	run_series(pszBackend, "module", *pAllocator, free_remote, nMaxThreads, nMilliseconds);
+	pAllocator->~Allocator();
+}
+
+}	// namespace
+
+
+int main(int argc, char* argv[])
+{
+	size_t nMaxThreads = argc > 1 ? size_t(std::atoi(argv[1])) : size_t(std::thread::hardware_concurrency());
+	const unsigned nMilliseconds = argc > 2 ? unsigned(std::atoi(argv[2])) : 300;
+	const char* pszPlugin = argc > 3 ? argv[3] : "./libscaling_plugin.so";
+	if (nMaxThreads < 1)
+		nMaxThreads = 1;
+	if (nMaxThreads > ring_capacity / batches_per_thread)
+		nMaxThreads = ring_capacity / batches_per_thread;
+
+	std::printf("%-12s %-7s %7s %12s %12s %8s %10s\n", "backend", "frees", "threads", "Mops/s", "Mops/s/thr", "speedup", "contention");
+	run_backend<kj::bench::default_node_allocator>("default", nMaxThreads, nMilliseconds);
+	run_backend<kj::bench::recycling_node_allocator>("recycling", nMaxThreads, nMilliseconds);
+	run_backend<kj::bench::segregated_node_allocator>("segregated", nMaxThreads, nMilliseconds);
+
+	if (void* hPlugin = ::dlopen(pszPlugin, RTLD_NOW | RTLD_LOCAL))
+	{
+		run_plugin_backend<kj::bench::default_node_allocator>("default", hPlugin, KJ_BENCH_PLUGIN_DEFAULT_ALLOCATOR, nMaxThreads, nMilliseconds);
+		run_plugin_backend<kj::bench::recycling_node_allocator>("recycling", hPlugin, KJ_BENCH_PLUGIN_RECYCLING_ALLOCATOR, nMaxThreads, nMilliseconds);
+		run_plugin_backend<kj::bench::segregated_node_allocator>("segregated", hPlugin, KJ_BENCH_PLUGIN_SEGREGATED_ALLOCATOR, nMaxThreads, nMilliseconds);
+		// the plugin stays loaded, its blocks were all freed but its caches live until exit
+	}
+	else
+		std::printf("# cross-module frees skipped: %s\n", ::dlerror());
+
+	return 0;
+}
@@ -0,0 +1,859 @@
+/**	@file	Module-bound containers with a fixed, compiler-independent layout.
+
+	The layout of @c std::vector or @c std::basic_string may differ between
+	compilers, standard library versions and compiler flags (e.g. debug
+	iterators), so modules built differently can't share them.
+	@c abi_vector and @c abi_string always consist of a data pointer,
+	the size, the capacity and a pointer to the module's raw memory operations
+	(in that order), and they grow, shrink and free their storage only through
+	those operations. Thus their storage can be handed between such modules
+	without conversion or copy.
+
+	@date	2026 10 17	kj	created
+ */
+
+#ifndef KJ_MODULEBOUND_ABI_H_INCLUDED
+#define KJ_MODULEBOUND_ABI_H_INCLUDED
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#  pragma once
+#endif
+
+#include <type_traits>
+#include <new>	// placement new, std::bad_alloc
+#include <stdexcept>	// std::length_error
+#include <iterator>	// std::iterator_traits, std::distance
+#include <utility>	// std::move, std::forward, std::move_if_noexcept
+#include <string>	// std::char_traits
+#include <stddef.h>
+#include "modulebound_allocator.h"
+
+
+namespace kj
+{
+
+/**	@short	Contiguous sequence of @c T with the fixed layout
+	{pointer, size, capacity, module ops pointer}.
+
+	Memory is allocated with the array allocation functions of the module
+	that constructed the vector; all later reallocations go through the
+	same module's operations, no matter which module grows the vector.
+
+	As with the module-bound allocator, copying captures the raw allocation
+	functions of the current module while moving takes over the storage
+	together with the operations of the originating module.
+
+	@attention	Sharing the vector between modules built with different
+	compilers requires @c T to have a compiler-independent layout itself,
+	e.g. a trivially copyable standard-layout type.
+ */
+template<typename T>
+class abi_vector
+{
+public:
+	typedef T value_type;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+	typedef T* pointer;
+	typedef const T* const_pointer;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef T* iterator;
+	typedef const T* const_iterator;
+
+
+private:
+	// the layout is part of the interface - don't reorder or add members
+	T* m_pData;
+	size_type m_nSize;
+	size_type m_nCapacity;
+	const module_ops* m_pOps;
+
+public:
+	/**	@short	Construct an empty vector bound to the current module
+	 */
+	abi_vector() throw():
+		m_pData(0),
+		m_nSize(0),
+		m_nCapacity(0),
+		m_pOps(detail::fetch_module_ops(true))
+	{}
+
+	/**	@short	Construct an empty vector bound to the module owning @e pOps
+	 */
+	explicit abi_vector(const module_ops* pOps) throw():
+		m_pData(0),
+		m_nSize(0),
+		m_nCapacity(0),
+		m_pOps(pOps)
+	{}
+
+	/**	@short	Construct @e nCount value-initialized elements
+		@throw	@c std::bad_alloc, or any exception thrown by @c T's constructor
+	 */
+	explicit abi_vector(size_type nCount):
+		m_pData(0),
+		m_nSize(0),
+		m_nCapacity(0),
+		m_pOps(detail::fetch_module_ops(true))
+	{
+		resize(nCount);
+	}
+
+	/**	@short	Construct @e nCount copies of @e value
+		@throw	@c std::bad_alloc, or any exception thrown by @c T's constructor
+	 */
+	abi_vector(size_type nCount, const T& value):
+		m_pData(0),
+		m_nSize(0),
+		m_nCapacity(0),
+		m_pOps(detail::fetch_module_ops(true))
+	{
+		resize(nCount, value);
+	}
+
+	/**	@short	Copy the elements of the range [first, last)
+		@throw	@c std::bad_alloc, or any exception thrown by @c T's constructor
+	 */
+	template<typename InputIterator>
+	abi_vector(InputIterator first, InputIterator last,
+			   typename std::enable_if<!std::is_integral<InputIterator>::value>::type* = 0):
+		m_pData(0),
+		m_nSize(0),
+		m_nCapacity(0),
+		m_pOps(detail::fetch_module_ops(true))
+	{
+		assign(first, last);
+	}
+
+	/**	@short	Copy construct, capture the raw allocation functions of the
+		current module
+	 */
+	abi_vector(const abi_vector& rOther):
+		m_pData(0),
+		m_nSize(0),
+		m_nCapacity(0),
+		m_pOps(detail::fetch_module_ops(true))
+	{
+		assign(rOther.begin(), rOther.end());
+	}
+
+	/**	@short	Take over the storage and the operations of @e rOther,
+		leaving @e rOther empty
+	 */
+	abi_vector(abi_vector&& rOther) throw():
+		m_pData(rOther.m_pData),
+		m_nSize(rOther.m_nSize),
+		m_nCapacity(rOther.m_nCapacity),
+		m_pOps(rOther.m_pOps)
+	{
+		rOther.m_pData = 0;
+		rOther.m_nSize = 0;
+		rOther.m_nCapacity = 0;
+	}
+
+	~abi_vector() throw()
+	{
+		clear();
+		release_storage();
+	}
+
+	/**	@short	Assign a copy of @e rOther, capture the raw allocation functions
+		of the current module
+	 */
+	abi_vector& operator =(const abi_vector& rOther)
+	{
+		if (this != &rOther)
+		{
+			abi_vector copy(rOther);
+			swap(copy);
+		}
+
+		return *this;
+	}
+
+	/**	@short	Free the current storage in its module and take over the
+		storage and the operations of @e rOther
+	 */
+	abi_vector& operator =(abi_vector&& rOther) throw()
+	{
+		if (this != &rOther)
+		{
+			abi_vector other(std::move(rOther));
+			swap(other);
+		}
+
+		return *this;
+	}
+
+	/**	@short	Replace the contents with the elements of the range [first, last)
+	 */
+	template<typename InputIterator>
+	void assign(InputIterator first, InputIterator last)
+	{
+		clear();
+		assign_range(first, last, typename std::iterator_traits<InputIterator>::iterator_category());
+	}
+
+	/**	@short	Exchange the storage and the operations of two vectors
+	 */
+	void swap(abi_vector& rOther) throw()
+	{
+		std::swap(m_pData, rOther.m_pData);
+		std::swap(m_nSize, rOther.m_nSize);
+		std::swap(m_nCapacity, rOther.m_nCapacity);
+		std::swap(m_pOps, rOther.m_pOps);
+	}
+
+	/**	@short	The raw memory operations of the module owning the storage
+	 */
+	const module_ops* get_module_ops() const throw()
+	{
+		return m_pOps;
+	}
+
+	/**	@short	Bind the storage to the module owning @e pOps.
+		If both modules' operations are built on the same heap only the 
+		operations are exchanged, otherwise the elements are moved into 
+		storage allocated through @e pOps.
+		@throw	@c std::bad_alloc, or any exception thrown by @c T's constructor
+	 */
+	void rehome(const module_ops* pOps)
+	{
+		if (pOps->heap == m_pOps->heap)
+			m_pOps = pOps;
+		else
+		{
+			abi_vector rehomed(pOps);
+			rehomed.reserve(m_nSize);
+			for (size_type i = 0; i != m_nSize; ++i)
+				rehomed.emplace_back(std::move_if_noexcept(m_pData[i]));
+			swap(rehomed);
+		}
+	}
+
+	pointer data() throw()
+	{
+		return m_pData;
+	}
+
+	const_pointer data() const throw()
+	{
+		return m_pData;
+	}
+
+	size_type size() const throw()
+	{
+		return m_nSize;
+	}
+
+	size_type capacity() const throw()
+	{
+		return m_nCapacity;
+	}
+
+	bool empty() const throw()
+	{
+		return m_nSize == 0;
+	}
+
+	size_type max_size() const throw()
+	{
+		return size_type(-1) / sizeof(T);
+	}
+
+	iterator begin() throw()
+	{
+		return m_pData;
+	}
+
+	const_iterator begin() const throw()
+	{
+		return m_pData;
+	}
+
+	iterator end() throw()
+	{
+		return m_pData + m_nSize;
+	}
+
+	const_iterator end() const throw()
+	{
+		return m_pData + m_nSize;
+	}
+
+	reference operator [](size_type i) throw()
+	{
+		return m_pData[i];
+	}
+
+	const_reference operator [](size_type i) const throw()
+	{
+		return m_pData[i];
+	}
+
+	reference front() throw()
+	{
+		return m_pData[0];
+	}
+
+	const_reference front() const throw()
+	{
+		return m_pData[0];
+	}
+
+	reference back() throw()
+	{
+		return m_pData[m_nSize - 1];
+	}
+
+	const_reference back() const throw()
+	{
+		return m_pData[m_nSize - 1];
+	}
+
+	/**	@short	Make room for at least @e nCapacity elements
+		@throw	@c std::bad_alloc, @c std::length_error
+	 */
+	void reserve(size_type nCapacity)
+	{
+		if (nCapacity > m_nCapacity)
+			reallocate(nCapacity);
+	}
+
+	/**	@short	Resize to @e nCount elements, value-initialize new ones
+	 */
+	void resize(size_type nCount)
+	{
+		if (nCount < m_nSize)
+			destroy_from(nCount);
+		else
+		{
+			reserve(nCount);
+			while (m_nSize != nCount)
+				emplace_back();
+		}
+	}
+
+	/**	@short	Resize to @e nCount elements, copy @e value into new ones
+	 */
+	void resize(size_type nCount, const T& value)
+	{
+		if (nCount < m_nSize)
+			destroy_from(nCount);
+		else
+		{
+			// take a copy, value might refer to an element
+			T copy(value);
+			reserve(nCount);
+			while (m_nSize != nCount)
+				emplace_back(copy);
+		}
+	}
+
+	void push_back(const T& value)
+	{
+		emplace_back(value);
+	}
+
+	void push_back(T&& value)
+	{
+		emplace_back(std::move(value));
+	}
+
+	/**	@short	Construct an element at the end from @e args
+		@throw	@c std::bad_alloc, or any exception thrown by @c T's constructor
+	 */
+	template<typename... Args>
+	reference emplace_back(Args&&... args)
+	{
+		if (m_nSize == m_nCapacity)
+			grow_and_emplace_back(std::forward<Args>(args)...);
+		else
+		{
+			::new (static_cast<void*>(m_pData + m_nSize)) T(std::forward<Args>(args)...);
+			++m_nSize;
+		}
+
+		return back();
+	}
+
+	void pop_back() throw()
+	{
+		m_pData[--m_nSize].~T();
+	}
+
+	/**	@short	Destroy all elements, keep the storage
+	 */
+	void clear() throw()
+	{
+		destroy_from(0);
+	}
+
+
+private:
+	template<typename InputIterator>
+	void assign_range(InputIterator first, InputIterator last, std::input_iterator_tag)
+	{
+		for (; first != last; ++first)
+			emplace_back(*first);
+	}
+
+	template<typename ForwardIterator>
+	void assign_range(ForwardIterator first, ForwardIterator last, std::forward_iterator_tag)
+	{
+		reserve(size_type(std::distance(first, last)));
+		for (; first != last; ++first)
+			emplace_back(*first);
+	}
+
+	void destroy_from(size_type nCount) throw()
+	{
+		while (m_nSize != nCount)
+			m_pData[--m_nSize].~T();
+	}
+
+	void release_storage() throw()
+	{
+		if (m_pData)
+			m_pOps->deallocate(m_pData);
+		m_pData = 0;
+		m_nCapacity = 0;
+	}
+
+	// allocate storage for nCapacity elements through the owning module
+	T* allocate_storage(size_type nCapacity) const
+	{
+		if (nCapacity > max_size())
+			throw std::length_error("kj::abi_vector");
+		return static_cast<T*>(m_pOps->allocate(nCapacity * sizeof(T)));
+	}
+
+	size_type grown_capacity() const throw()
+	{
+		return m_nCapacity ? m_nCapacity + m_nCapacity / 2 + 1 : 4;
+	}
+
+	// move the elements into new storage of nCapacity elements
+	void reallocate(size_type nCapacity)
+	{
+		T* pData = allocate_storage(nCapacity);
+		try
+		{
+			relocate_into(pData);
+		}
+		catch (...)
+		{
+			m_pOps->deallocate(pData);
+			throw;
+		}
+		adopt_storage(pData, nCapacity);
+	}
+
+	// construct the new element first, args might refer to an existing element
+	template<typename... Args>
+	void grow_and_emplace_back(Args&&... args)
+	{
+		const size_type nCapacity = grown_capacity();
+		T* pData = allocate_storage(nCapacity);
+		try
+		{
+			::new (static_cast<void*>(pData + m_nSize)) T(std::forward<Args>(args)...);
+		}
+		catch (...)
+		{
+			m_pOps->deallocate(pData);
+			throw;
+		}
+
+		try
+		{
+			relocate_into(pData);
+		}
+		catch (...)
+		{
+			pData[m_nSize].~T();
+			m_pOps->deallocate(pData);
+			throw;
+		}
+
+		adopt_storage(pData, nCapacity);
+		++m_nSize;
+	}
+
+	// move or copy all elements into pData; on failure the elements 
+	// constructed in pData are destroyed, freeing pData is up to the caller
+	void relocate_into(T* pData)
+	{
+		size_type i = 0;
+		try
+		{
+			for (; i != m_nSize; ++i)
+				::new (static_cast<void*>(pData + i)) T(std::move_if_noexcept(m_pData[i]));
+		}
+		catch (...)
+		{
+			while (i != 0)
+				pData[--i].~T();
+			throw;
+		}
+	}
+
+	// destroy the old elements and switch to the already populated storage
+	void adopt_storage(T* pData, size_type nCapacity) throw()
+	{
+		const size_type nSize = m_nSize;
+		clear();
+		release_storage();
+		m_pData = pData;
+		m_nSize = nSize;
+		m_nCapacity = nCapacity;
+	}
+};
+
+
+template<typename T> inline
+void swap(abi_vector<T>& rLeft, abi_vector<T>& rRight) throw()
+{
+	rLeft.swap(rRight);
+}
+
+template<typename T> inline
+bool operator ==(const abi_vector<T>& rLeft, const abi_vector<T>& rRight)
+{
+	if (rLeft.size() != rRight.size())
+		return false;
+	for (size_t i = 0; i != rLeft.size(); ++i)
+		if (!(rLeft[i] == rRight[i]))
+			return false;
+	return true;
+}
+
+template<typename T> inline
+bool operator !=(const abi_vector<T>& rLeft, const abi_vector<T>& rRight)
+{
+	return !(rLeft == rRight);
+}
+
+
+/**	@short	Null-terminated character sequence with the same fixed layout as
+	@c abi_vector<CharT>.
+
+	The stored capacity accounts for the terminating null character,
+	which is always present once the string has storage.
+ */
+template<typename CharT, typename Traits = std::char_traits<CharT> >
+class basic_abi_string
+{
+	static_assert(std::is_trivially_copyable<CharT>::value && std::is_standard_layout<CharT>::value,
+				  "character type must have a compiler-independent layout");
+
+	// characters including the terminating null character
+	abi_vector<CharT> m_chars;
+
+public:
+	typedef Traits traits_type;
+	typedef CharT value_type;
+	typedef size_t size_type;
+	typedef const CharT* const_iterator;
+	typedef CharT* iterator;
+
+
+public:
+	basic_abi_string() throw():
+		m_chars()
+	{}
+
+	basic_abi_string(const CharT* psz):
+		m_chars()
+	{
+		assign(psz, Traits::length(psz));
+	}
+
+	basic_abi_string(const CharT* p, size_type nLength):
+		m_chars()
+	{
+		assign(p, nLength);
+	}
+
+	/**	@short	Copy the characters of any string type exposing data() and size(),
+		e.g. a @c std::basic_string using the module-bound allocator
+	 */
+	template<typename String>
+	explicit basic_abi_string(const String& rOther,
+							  typename std::enable_if<std::is_same<typename String::value_type, CharT>::value>::type* = 0):
+		m_chars()
+	{
+		assign(rOther.data(), rOther.size());
+	}
+
+	// copy captures the current module, move keeps the originating module (see abi_vector)
+	basic_abi_string(const basic_abi_string& rOther):
+		m_chars(rOther.m_chars)
+	{}
+
+	basic_abi_string(basic_abi_string&& rOther) throw():
+		m_chars(std::move(rOther.m_chars))
+	{}
+
+	basic_abi_string& operator =(const basic_abi_string& rOther)
+	{
+		m_chars = rOther.m_chars;
+		return *this;
+	}
+
+	basic_abi_string& operator =(basic_abi_string&& rOther) throw()
+	{
+		m_chars = std::move(rOther.m_chars);
+		return *this;
+	}
+
+	basic_abi_string& operator =(const CharT* psz)
+	{
+		assign(psz, Traits::length(psz));
+		return *this;
+	}
+
+	/**	@short	Replace the contents with the @e nLength characters at @e p
+	 */
+	basic_abi_string& assign(const CharT* p, size_type nLength)
+	{
+		if (p >= data() && p <= data() + size() && !m_chars.empty())
+		{
+			// assign from a part of ourselves
+			basic_abi_string copy(p, nLength);
+			swap(copy);
+		}
+		else
+		{
+			m_chars.clear();
+			m_chars.reserve(nLength + 1);
+			m_chars.assign(p, p + nLength);
+			m_chars.push_back(CharT());
+		}
+
+		return *this;
+	}
+
+	/**	@short	Append the @e nLength characters at @e p
+	 */
+	basic_abi_string& append(const CharT* p, size_type nLength)
+	{
+		if (p >= data() && p <= data() + size() && !m_chars.empty())
+		{
+			basic_abi_string copy(p, nLength);
+			return append(copy.data(), copy.size());
+		}
+
+		if (m_chars.empty())
+			m_chars.push_back(CharT());
+		m_chars.reserve(m_chars.size() + nLength);
+		m_chars.pop_back();
+		for (size_type i = 0; i != nLength; ++i)
+			m_chars.push_back(p[i]);
+		m_chars.push_back(CharT());
+
+		return *this;
+	}
+
+	basic_abi_string& append(const CharT* psz)
+	{
+		return append(psz, Traits::length(psz));
+	}
+
+	basic_abi_string& operator +=(const basic_abi_string& rOther)
+	{
+		return append(rOther.data(), rOther.size());
+	}
+
+	basic_abi_string& operator +=(const CharT* psz)
+	{
+		return append(psz);
+	}
+
+	basic_abi_string& operator +=(CharT c)
+	{
+		return append(&c, 1);
+	}
+
+	void push_back(CharT c)
+	{
+		append(&c, 1);
+	}
+
+	void reserve(size_type nCapacity)
+	{
+		m_chars.reserve(nCapacity + 1);
+	}
+
+	void clear() throw()
+	{
+		if (!m_chars.empty())
+		{
+			m_chars.clear();
+			m_chars.push_back(CharT());
+		}
+	}
+
+	void swap(basic_abi_string& rOther) throw()
+	{
+		m_chars.swap(rOther.m_chars);
+	}
+
+	/**	@short	The raw memory operations of the module owning the storage
+	 */
+	const module_ops* get_module_ops() const throw()
+	{
+		return m_chars.get_module_ops();
+	}
+
+	/**	@short	Bind the storage to the module owning @e pOps, see abi_vector::rehome()
+	 */
+	void rehome(const module_ops* pOps)
+	{
+		m_chars.rehome(pOps);
+	}
+
+	const CharT* c_str() const throw()
+	{
+		static const CharT s_empty = CharT();
+		return m_chars.empty() ? &s_empty : m_chars.data();
+	}
+
+	const CharT* data() const throw()
+	{
+		return c_str();
+	}
+
+	size_type size() const throw()
+	{
+		return m_chars.empty() ? 0 : m_chars.size() - 1;
+	}
+
+	size_type length() const throw()
+	{
+		return size();
+	}
+
+	size_type capacity() const throw()
+	{
+		return m_chars.capacity() ? m_chars.capacity() - 1 : 0;
+	}
+
+	bool empty() const throw()
+	{
+		return size() == 0;
+	}
+
+	const_iterator begin() const throw()
+	{
+		return data();
+	}
+
+	const_iterator end() const throw()
+	{
+		return data() + size();
+	}
+
+	iterator begin() throw()
+	{
+		return m_chars.data();
+	}
+
+	iterator end() throw()
+	{
+		return m_chars.data() + size();
+	}
+
+	CharT& operator [](size_type i) throw()
+	{
+		return m_chars[i];
+	}
+
+	const CharT& operator [](size_type i) const throw()
+	{
+		return data()[i];
+	}
+
+	/**	@short	Compare lexicographically with the @e nLength characters at @e p
+	 */
+	int compare(const CharT* p, size_type nLength) const throw()
+	{
+		const size_type nSize = size();
+		const int nResult = Traits::compare(data(), p, nSize < nLength ? nSize : nLength);
+		if (nResult != 0)
+			return nResult;
+		return nSize < nLength ? -1 : (nSize > nLength ? 1 : 0);
+	}
+
+	int compare(const basic_abi_string& rOther) const throw()
+	{
+		return compare(rOther.data(), rOther.size());
+	}
+};
+
+
+template<typename CharT, typename Traits> inline
+void swap(basic_abi_string<CharT, Traits>& rLeft, basic_abi_string<CharT, Traits>& rRight) throw()
+{
+	rLeft.swap(rRight);
+}
+
+template<typename CharT, typename Traits> inline
+bool operator ==(const basic_abi_string<CharT, Traits>& rLeft, const basic_abi_string<CharT, Traits>& rRight) throw()
+{
+	return rLeft.compare(rRight) == 0;
+}
+
+template<typename CharT, typename Traits> inline
+bool operator !=(const basic_abi_string<CharT, Traits>& rLeft, const basic_abi_string<CharT, Traits>& rRight) throw()
+{
+	return rLeft.compare(rRight) != 0;
+}
+
+template<typename CharT, typename Traits> inline
+bool operator <(const basic_abi_string<CharT, Traits>& rLeft, const basic_abi_string<CharT, Traits>& rRight) throw()
+{
+	return rLeft.compare(rRight) < 0;
+}
+
+template<typename CharT, typename Traits> inline
+bool operator ==(const basic_abi_string<CharT, Traits>& rLeft, const CharT* pszRight) throw()
+{
+	return rLeft.compare(pszRight, Traits::length(pszRight)) == 0;
+}
+
+template<typename CharT, typename Traits> inline
+bool operator !=(const basic_abi_string<CharT, Traits>& rLeft, const CharT* pszRight) throw()
+{
+	return !(rLeft == pszRight);
+}
+
+
+typedef basic_abi_string<char> abi_string;
+typedef basic_abi_string<wchar_t> abi_wstring;
+
+
+namespace detail
+{
+
+// the layout of the abi types must not depend on the element type
+struct abi_layout_probe
+{
+	void* pData;
+	size_t nSize;
+	size_t nCapacity;
+	const module_ops* pOps;
+};
+
+static_assert(sizeof(abi_vector<char>) == sizeof(abi_layout_probe), "unexpected abi_vector layout");
+static_assert(sizeof(abi_string) == sizeof(abi_layout_probe), "unexpected abi_string layout");
+static_assert(std::is_standard_layout<abi_vector<char> >::value, "abi_vector must be standard-layout");
+
+}	// namespace detail
+
+
+}	// namespace kj
+
+
+#endif	// file guard
@@ -64,7 +64,10 @@
 #include <new>	// operator new/operator delete
 #include <memory>	// std::allocator
 #include <utility>	// std::pair, std::move
+#include <stdlib.h>	// malloc
 #include "modulebound_allocator_fwddecl.h"
+#include "modulebound_pool.h"
+#include "modulebound_lifecycle.h"
 
 
 namespace kj
@@ -83,23 +86,316 @@ struct remove_reference_and_all_extents
 };
 
 
+// metafunction telling whether T is a module-bound allocator
+template<typename T>
+struct is_modulebound_allocator: std::false_type
+{};
+
+template<typename T, typename RawAllocation>
+struct is_modulebound_allocator<modulebound_allocator<T, RawAllocation> >: std::true_type
+{};
+
+
+// metafunction telling whether T declares a nested allocator_type
+template<typename T>
+struct has_allocator_type
+{
+	template<typename U> static char test(typename U::allocator_type*);
+	template<typename U> static long test(...);
+
+	static const bool value = sizeof(test<T>(0)) == sizeof(char);
+};
+
+// metafunction telling whether T is a container using a module-bound allocator
+template<typename T, bool = has_allocator_type<T>::value>
+struct is_modulebound_container: std::false_type
+{};
+
+template<typename T>
+struct is_modulebound_container<T, true>: is_modulebound_allocator<typename T::allocator_type>
+{};
+
+
+// module_ops table functions forwarding to the raw operators
+inline
+void* ops_operator_new(const module_ops*, size_t nBytes)
+{
+	return ::operator new(nBytes);
+}
+
+inline
+void* ops_operator_new_array(const module_ops*, size_t nBytes)
+{
+	return ::operator new[](nBytes);
+}
+
+inline
+void ops_operator_delete(const module_ops*, void* p, size_t) throw()
+{
+	::operator delete(p);
+}
+
+inline
+void ops_operator_delete_array(const module_ops*, void* p, size_t) throw()
+{
+	::operator delete[](p);
+}
+
+// module_ops table of the module's pool for blocks allocated with a hint; 
+// the pools are never destroyed, so blocks freed during static destruction 
+// find them intact
+template<bool IsArray, hint::temperature Temperature>
+struct hinted_ops
+{
+	typedef size_class_pool<pool_mutex> pool_type;
+
+	static pool_type& pool()
+	{
+		static typename std::aligned_storage<sizeof(pool_type), alignof(pool_type)>::type s_storage;
+		static pool_type* s_pPool = ::new (static_cast<void*>(&s_storage)) pool_type(
+			IsArray ? fp_raw_allocate_t(::operator new[]) : fp_raw_allocate_t(::operator new), 
+			IsArray ? fp_raw_deallocate_t(::operator delete[]) : fp_raw_deallocate_t(::operator delete)
+		);
+		static pool_closer<pool_type> s_closer(*s_pPool);
+		register_module_cache<&trim, &statistics>();
+		register_fork_handlers<&lock_pool, &unlock_pool, &unlock_pool>();
+		return *s_pPool;
+	}
+
+	static void trim()
+	{
+		pool().trim();
+	}
+
+	static void statistics(module_cache_statistics& rStats)
+	{
+		pool().add_statistics(rStats);
+	}
+
+	static void lock_pool()
+	{
+		pool().get_lock().lock();
+	}
+
+	static void unlock_pool()
+	{
+		pool().get_lock().unlock();
+	}
+
+	static void* ops_allocate(const module_ops*, size_t nBytes)
+	{
+		if (pool_type::serves(nBytes))
+			return pool().allocate(nBytes);
+		return IsArray ? ::operator new[](nBytes) : ::operator new(nBytes);
+	}
+
+	static void ops_deallocate(const module_ops*, void* p, size_t nBytes) throw()
+	{
+		if (pool_type::serves(nBytes))
+			pool().deallocate(p, nBytes);
+		else if (IsArray)
+			::operator delete[](p);
+		else
+			::operator delete(p);
+	}
+
+	// blocks of a size known at compile time, the size class is a constant
+	template<size_t nBytes>
+	static void* allocate_fixed()
+	{
+		if (pool_type::serves(nBytes))
+			return pool().allocate_class(pool_class_of<nBytes>::value);
+		return IsArray ? ::operator new[](nBytes) : ::operator new(nBytes);
+	}
+
+	template<size_t nBytes>
+	static void deallocate_fixed(void* p) throw()
+	{
+		if (pool_type::serves(nBytes))
+			pool().deallocate_class(p, pool_class_of<nBytes>::value);
+		else if (IsArray)
+			::operator delete[](p);
+		else
+			::operator delete(p);
+	}
+
+	static const module_ops* fetch() throw()
+	{
+		// the raw functions don't know the block size and bypass the pool
+		static const module_ops s_ops = 
+		{
+			IsArray ? fp_raw_allocate_t(::operator new[]) : fp_raw_allocate_t(::operator new), 
+			IsArray ? fp_raw_deallocate_t(::operator delete[]) : fp_raw_deallocate_t(::operator delete), 
+			&s_ops, 
+			&ops_allocate, &ops_deallocate, 
+			false, 
+			0, 0
+		};
+
+		return &s_ops;
+	}
+};
+
+// allocate nBytes with the hinted table pOps; 
+// directly from the pool if pOps is the current module's
+template<bool IsArray, size_t nBytes> inline
+void* allocate_hinted_fixed(const module_ops* pOps)
+{
+	if (pOps == hinted_ops<IsArray, hint::hot>::fetch())
+		return hinted_ops<IsArray, hint::hot>::template allocate_fixed<nBytes>();
+	if (pOps == hinted_ops<IsArray, hint::cold>::fetch())
+		return hinted_ops<IsArray, hint::cold>::template allocate_fixed<nBytes>();
+	return pOps->ops_allocate(pOps, nBytes);
+}
+
+template<bool IsArray, size_t nBytes> inline
+void deallocate_hinted_fixed(const module_ops* pOps, void* p) throw()
+{
+	if (pOps == hinted_ops<IsArray, hint::hot>::fetch())
+		hinted_ops<IsArray, hint::hot>::template deallocate_fixed<nBytes>(p);
+	else if (pOps == hinted_ops<IsArray, hint::cold>::fetch())
+		hinted_ops<IsArray, hint::cold>::template deallocate_fixed<nBytes>(p);
+	else
+		pOps->ops_deallocate(pOps, p, nBytes);
+}
+
+// helper function returning the module's table of raw memory operations;
+// the table is a function-local static so each module refers to its own one.
+// The default operators are built on the c runtime's malloc, which identifies 
+// the heap: modules sharing a dynamically linked c runtime share the heap, 
+// modules linked against the static runtime don't.
+// Define KJ_MODULEBOUND_CUSTOM_OPERATOR_NEW if a module replaces the global 
+// operator new with one not built on malloc.
+inline	// force inline to prevent multiple function definitions in multiple translation units
+const module_ops* fetch_module_ops(bool is_array_allocation)
+{
+#ifdef KJ_MODULEBOUND_CUSTOM_OPERATOR_NEW
+#  define KJ_MODULEBOUND_HEAP_ID reinterpret_cast<const void*>(fp_raw_allocate_t(::operator new))
+#else
+#  define KJ_MODULEBOUND_HEAP_ID reinterpret_cast<const void*>(fp_raw_allocate_t(::malloc))
+#endif
+
+	// capture operator new/operator delete;
+	// must do a cast (value-cast) because operators are overloaded
+	static const module_ops s_ops[2] = 
+	{
+		{ 
+			fp_raw_allocate_t(::operator new), fp_raw_deallocate_t(::operator delete), 
+			KJ_MODULEBOUND_HEAP_ID, 
+			&ops_operator_new, &ops_operator_delete, 
+			false, 
+			hinted_ops<false, hint::hot>::fetch(), hinted_ops<false, hint::cold>::fetch()
+		}, 
+		{ 
+			fp_raw_allocate_t(::operator new[]), fp_raw_deallocate_t(::operator delete[]), 
+			KJ_MODULEBOUND_HEAP_ID, 
+			&ops_operator_new_array, &ops_operator_delete_array, 
+			false, 
+			hinted_ops<true, hint::hot>::fetch(), hinted_ops<true, hint::cold>::fetch()
+		}
+	};
+
+#undef KJ_MODULEBOUND_HEAP_ID
+
+	return &s_ops[is_array_allocation ? 1 : 0];
+}
+
 // helper function to create a pair of raw allocator functions
 inline	// force inline to prevent multiple function definitions in multiple translation units
 std::pair<fp_raw_allocate_t, fp_raw_deallocate_t>
 fetch_raw_operators(bool is_array_allocation)
 {
-	return
-			std::make_pair(
-				// capture operator new/operator delete;
-				// must do a cast (value-cast) because operators are overloaded
-				is_array_allocation ? fp_raw_allocate_t(::operator new[]) : fp_raw_allocate_t(::operator new), 
-				is_array_allocation ? fp_raw_deallocate_t(::operator delete[]) : fp_raw_deallocate_t(::operator delete)
-			);
+	const module_ops* pOps = fetch_module_ops(is_array_allocation);
+	return std::make_pair(pOps->allocate, pOps->deallocate);
+}
+
+
+// function pointer type giving access to a region slot
+typedef const module_ops** (*fp_region_slot_t)();
+
+// this module's slot holding the table of the allocation region active 
+// on the calling thread, if any (see modulebound_region.h)
+inline
+const module_ops** module_region_slot() throw()
+{
+	static thread_local const module_ops* s_pRegionOps = 0;
+	return &s_pRegionOps;
+}
+
+// the region slot in use by this module; 
+// modules may be linked to the slot of another module
+inline
+fp_region_slot_t& region_slot_accessor() throw()
+{
+	static fp_region_slot_t s_pfnSlot = &module_region_slot;
+	return s_pfnSlot;
 }
 
 }	// namespace detail
 
 
+/**	@short	Tag constructing a module-bound allocator bound to the current 
+	module's table for its allocation mode, ignoring the allocation region 
+	active on the calling thread (see modulebound_region.h); 
+	for allocators of storage outliving any region, e.g. inside the library
+ */
+struct ignore_region_t
+{};
+
+const ignore_region_t ignore_region = ignore_region_t();
+
+
+/**	@short	Default allocation modes use the c++ runtime's operator new/operator delete 
+	or their array counterparts.
+ */
+template<typename RawAllocation, typename T>
+struct allocation_mode_traits
+{
+	///	Capture the table of raw memory operations available to the current translation unit
+	static const module_ops* fetch_module_ops(bool is_array_allocation) throw()
+	{
+		return detail::fetch_module_ops(is_array_allocation);
+	}
+};
+
+
+/**	@short	Serves blocks of a size known at compile time for an allocation mode.
+
+	The default goes through the allocator's table. Allocation modes with
+	size classes specialize it to resolve the class at compile time when the
+	allocator is bound to the mode's table of the current module, falling
+	back to the table otherwise (e.g. for blocks of another module).
+ */
+template<typename RawAllocation>
+struct fixed_size_allocation_traits
+{
+	template<bool IsArray, size_t nBytes>
+	static void* allocate(const module_ops* pOps)
+	{
+		return pOps->ops_allocate(pOps, nBytes);
+	}
+
+	template<bool IsArray, size_t nBytes>
+	static void deallocate(const module_ops* pOps, void* p) throw()
+	{
+		pOps->ops_deallocate(pOps, p, nBytes);
+	}
+};
+
+
+/**	@short	Whether allocators of an allocation mode always bind to the mode's 
+	table, ignoring an active allocation region (see modulebound_region.h) 
+	and tables managing storage of their own when copied.
+
+	Allocation modes whose blocks have a layout of their own, relied upon by 
+	code outside the allocator (e.g. headers read by C code), specialize it 
+	as @c std::true_type.
+ */
+template<typename RawAllocation>
+struct allocation_mode_ignores_region: std::false_type
+{};
+
+
 /**	@short	Base class for all module-bound allocators
 
 	Makes the default stl allocator functionality available by deriving publicly 
@@ -126,10 +422,31 @@ class modulebound_allocator_base:
 {
 	typedef std::allocator<typename detail::remove_reference_and_all_extents<T>::type> base;
 	typedef std::pair<fp_raw_allocate_t, fp_raw_deallocate_t> raw_operators;
+	typedef allocation_mode_traits<RawAllocation, typename detail::remove_reference_and_all_extents<T>::type> mode_traits;
+
+
+	// refers to the module's operator new/operator delete
+	const module_ops* m_pModuleOps;
 
 
-	// stores operator new/operator delete
-	raw_operators m_raw_operators;
+	// capture the table of the allocation region active on the calling thread, 
+	// or else the module's table for the allocation mode
+	static const module_ops* capture_module_ops() throw()
+	{
+		if (!allocation_mode_ignores_region<RawAllocation>::value)
+			if (const module_ops* pRegionOps = *detail::region_slot_accessor()())
+				return pRegionOps;
+		return mode_traits::fetch_module_ops(is_array_allocation::value);
+	}
+
+	// capture the module's table for the allocation mode when copying, 
+	// unless the source is bound to a table managing storage of its own
+	static const module_ops* capture_module_ops(const module_ops* pOtherOps) throw()
+	{
+		if (pOtherOps->keep_on_copy && !allocation_mode_ignores_region<RawAllocation>::value)
+			return pOtherOps;
+		return mode_traits::fetch_module_ops(is_array_allocation::value);
+	}
 
 public:
 	///	Convert a @c modulebound_allocator<T> to a @c modulebound_allocator<U>, 
@@ -148,6 +465,13 @@ public:
 			> 
 			is_array_allocation; 
 
+	///	Allocators originating from different modules are not interchangeable
+	typedef std::false_type is_always_equal;
+	///	Storage and the allocator it was allocated with travel together 
+	///	on container move assignment and swap
+	typedef std::true_type propagate_on_container_move_assignment;
+	typedef std::true_type propagate_on_container_swap;
+
 
 protected:
 
@@ -157,7 +481,23 @@ protected:
 	modulebound_allocator_base() throw(): 
 		base(), 
 		// capture operator new/operator delete
-		m_raw_operators(detail::fetch_raw_operators(is_array_allocation::value))
+		m_pModuleOps(capture_module_ops())
+	{}
+
+	/**	@short	Capture the current module's table for the allocation mode, 
+		even while a region is active.
+	 */
+	explicit modulebound_allocator_base(ignore_region_t) throw(): 
+		base(), 
+		m_pModuleOps(mode_traits::fetch_module_ops(is_array_allocation::value))
+	{}
+
+	/**	@short	Bind to the table @e pModuleOps, 
+		e.g. one recorded along with storage of another module.
+	 */
+	explicit modulebound_allocator_base(const module_ops* pModuleOps) throw(): 
+		base(), 
+		m_pModuleOps(pModuleOps)
 	{}
 
 	// ~modulebound_allocator_base() throw() = default;
@@ -167,7 +507,7 @@ protected:
 	modulebound_allocator_base(const modulebound_allocator_base& rOther) throw(): 
 		base(rOther), 
 		// capture operator new/operator delete
-		m_raw_operators(detail::fetch_raw_operators(is_array_allocation::value))
+		m_pModuleOps(capture_module_ops(rOther.get_module_ops()))
 	{}
 
 	/**	@short	Assign from other modulebound_allocator_bases, 
@@ -177,7 +517,7 @@ protected:
 	{
 		base::operator =(rOther);
 		if (this != &rOther)
-			m_raw_operators = detail::fetch_raw_operators(is_array_allocation::value);
+			m_pModuleOps = capture_module_ops(rOther.get_module_ops());
 
 		return *this;
 	}
@@ -189,7 +529,7 @@ protected:
 	modulebound_allocator_base(const modulebound_allocator_base<U, RawAllocationU>& rOther) throw(): 
 		base(rOther), 
 		// capture operator new/operator delete
-		m_raw_operators(detail::fetch_raw_operators(is_array_allocation::value))
+		m_pModuleOps(capture_module_ops(rOther.get_module_ops()))
 	{
 #if (_MSC_VER >= 1600)	// c++0x
 		static_assert(is_array_allocation::value == A_other::is_array_allocation::value, "raw allocation type mismatch (array/single object allocation)");
@@ -220,19 +560,19 @@ protected:
 
 		base::operator =(rOther);
 		if (this != static_cast<const void*>(&rOther))
-			m_raw_operators = detail::fetch_raw_operators(is_array_allocation::value);
+			m_pModuleOps = capture_module_ops(rOther.get_module_ops());
 
 		return *this;
 	}
 
-#if (_MSC_VER >= 1600)	// move semantics
+#if (_MSC_VER >= 1600) || (__cplusplus >= 201103L)	// move semantics
 	/**	@short	Move construct from other modulebound_allocator_bases of different types, 
 		copy operator new/operator delete from other allocator 
 		(other allocator is not deprived of its state)
 	 */
 	modulebound_allocator_base(const modulebound_allocator_base&& rOther) throw(): 
 		base(std::move(rOther)), 
-		m_raw_operators(rOther.get_raw_operators())
+		m_pModuleOps(rOther.get_module_ops())
 	{}
 
 	/**	@short	Move assign from other modulebound_allocator_bases of different types, 
@@ -243,7 +583,7 @@ protected:
 	{
 		base::operator =(std::move(rOther));
 		if (this != &rOther)
-			m_raw_operators = rOther.get_raw_operators();
+			m_pModuleOps = rOther.get_module_ops();
 
 		return *this;
 	}
@@ -256,7 +596,7 @@ protected:
 	template<typename U, typename RawAllocationU>
 	modulebound_allocator_base(const modulebound_allocator_base<U, RawAllocationU>&& rOther) throw(): 
 		base(std::move(rOther)), 
-		m_raw_operators(rOther.get_raw_operators())
+		m_pModuleOps(rOther.get_module_ops())
 	{
 		typedef modulebound_allocator_base<U, RawAllocationU> A_other;
 #if 0	// c++0x
@@ -289,7 +629,7 @@ protected:
 
 		base::operator =(std::move(rOther));
 		if (this != static_cast<const void*>(&rOther))
-			m_raw_operators = rOther.get_raw_operators();
+			m_pModuleOps = rOther.get_module_ops();
 
 		return *this;
 	}
@@ -300,7 +640,23 @@ public:
 	 */
 	raw_operators get_raw_operators() const throw()
 	{
-		return m_raw_operators;
+		return raw_operators(m_pModuleOps->allocate, m_pModuleOps->deallocate);
+	}
+
+	/**	@short	Make the module's table of raw memory operations available to the caller
+	 */
+	const module_ops* get_module_ops() const throw()
+	{
+		return m_pModuleOps;
+	}
+
+	/**	@short	The table for blocks allocated with hint @e eHint, 
+		or the module's table if hints are ignored
+	 */
+	const module_ops* get_hinted_module_ops(hint::temperature eHint) const throw()
+	{
+		const module_ops* pHintedOps = eHint == hint::hot ? m_pModuleOps->hot : m_pModuleOps->cold;
+		return pHintedOps ? pHintedOps : m_pModuleOps;
 	}
 };
 
@@ -368,10 +724,10 @@ class modulebound_allocator: public modulebound_allocator_base<T, RawAllocation>
 
 public:
 	// bring base types into template resolution scope
-	using base::pointer;
-	using base::const_pointer;
-	using base::size_type;
-	using base::value_type;
+	typedef typename base::value_type value_type;
+	typedef typename base::size_type size_type;
+	typedef value_type* pointer;
+	typedef const value_type* const_pointer;
 
 
 public:
@@ -379,6 +735,18 @@ public:
 		base()
 	{}
 
+	/**	@short	Bind to the current module ignoring an active region
+	 */
+	explicit modulebound_allocator(ignore_region_t tag) throw(): 
+		base(tag)
+	{}
+
+	/**	@short	Bind to the table @e pModuleOps
+	 */
+	explicit modulebound_allocator(const module_ops* pModuleOps) throw(): 
+		base(pModuleOps)
+	{}
+
 	// c++0x
 	//~modulebound_allocator() throw() = default;
 	//modulebound_allocator(const modulebound_allocator& rOther) throw() = default;
@@ -402,7 +770,18 @@ public:
 		return *this;
 	}
 
-#if (_MSC_VER >= 1600)	// move semantics
+#if (_MSC_VER >= 1600) || (__cplusplus >= 201103L)	// move semantics
+	// declaring the move constructor suppresses the implicit copy operations
+	modulebound_allocator(const modulebound_allocator& rOther) throw(): 
+		base(rOther)
+	{}
+
+	modulebound_allocator& operator =(const modulebound_allocator& rOther) throw()
+	{
+		base::operator =(rOther);
+		return *this;
+	}
+
 	/**	@short	Move construct from other modulebound_allocators
 	 */
 	modulebound_allocator(const modulebound_allocator&& rOther) throw()
@@ -431,7 +810,7 @@ public:
 	template<typename U, typename RawAllocationU>
 	modulebound_allocator& operator =(const modulebound_allocator<U, RawAllocationU>&& rOther) throw()
 	{
-		base::operator =(std::move(Other));
+		base::operator =(std::move(rOther));
 		return *this;
 	}
 #endif
@@ -443,7 +822,8 @@ public:
 	pointer allocate(size_type nCount)
 	{
 		return 
-			static_cast<pointer>(this->get_raw_operators().first(
+			static_cast<pointer>(this->get_module_ops()->ops_allocate(
+				this->get_module_ops(), 
 				sizeof(value_type) * nCount
 			));
 	}
@@ -460,14 +840,90 @@ public:
 		return this->allocate(nCount);
 	}
 
-	/**	@short	Deallocate object at @e p, ignore size
+	/**	@short	Allocate array of @e nCount elements in the arena for @e eHint 
+		of the allocator's module, which packs hot blocks together and keeps 
+		them apart from cold ones
+		@throw	@c std::bad_alloc
+		@note	Blocks must be deallocated with the same hint; 
+		allocation modes and regions not supporting hints ignore them.
+	 */
+	pointer allocate(size_type nCount, hint::temperature eHint)
+	{
+		const module_ops* pOps = this->get_hinted_module_ops(eHint);
+		return static_cast<pointer>(pOps->ops_allocate(pOps, sizeof(value_type) * nCount));
+	}
+
+	/**	@short	Allocate array of @e nCount elements, a number known at compile 
+		time (e.g. 1 for a node)
+
+		Allocation modes with size classes resolve the class at compile time.
+		@throw	@c std::bad_alloc
+	 */
+	template<size_type nCount>
+	pointer allocate()
+	{
+		return static_cast<pointer>(fixed_size_allocation_traits<RawAllocation>::template allocate<
+			base::is_array_allocation::value, 
+			sizeof(value_type) * nCount
+		>(this->get_module_ops()));
+	}
+
+	/**	@short	Allocate array of @e nCount elements, a number known at compile 
+		time, in the arena for @e eHint of the allocator's module; the size 
+		class of the arena's pool is resolved at compile time
+		@throw	@c std::bad_alloc
+	 */
+	template<size_type nCount>
+	pointer allocate(hint::temperature eHint)
+	{
+		return static_cast<pointer>(detail::allocate_hinted_fixed<
+			base::is_array_allocation::value, 
+			sizeof(value_type) * nCount
+		>(this->get_hinted_module_ops(eHint)));
+	}
+
+	/**	@short	Deallocate object at @e p, pass the size on to allocation modes 
+		that make use of it
 		@note	A number of common STL libraries contain bugs in their using of 
 		allocators. Specifically, they pass null pointers to the deallocate function, 
 		which is explicitly forbidden by the Standard [20.1.5 Table 32].
 	 */
-	void deallocate(pointer p, size_type) throw()
+	void deallocate(pointer p, size_type nCount) throw()
+	{
+		const module_ops* pOps = this->get_module_ops();
+		pOps->ops_deallocate(pOps, p, sizeof(value_type) * nCount);
+	}
+
+	/**	@short	Deallocate object at @e p allocated with hint @e eHint
+	 */
+	void deallocate(pointer p, size_type nCount, hint::temperature eHint) throw()
 	{
-		this->get_raw_operators().second(p);
+		const module_ops* pOps = this->get_hinted_module_ops(eHint);
+		pOps->ops_deallocate(pOps, p, sizeof(value_type) * nCount);
+	}
+
+	/**	@short	Deallocate array at @e p of @e nCount elements, a number known 
+		at compile time, allocated by allocate<nCount>()
+	 */
+	template<size_type nCount>
+	void deallocate(pointer p) throw()
+	{
+		fixed_size_allocation_traits<RawAllocation>::template deallocate<
+			base::is_array_allocation::value, 
+			sizeof(value_type) * nCount
+		>(this->get_module_ops(), p);
+	}
+
+	/**	@short	Deallocate array at @e p of @e nCount elements, a number known 
+		at compile time, allocated by allocate<nCount>(eHint)
+	 */
+	template<size_type nCount>
+	void deallocate(pointer p, hint::temperature eHint) throw()
+	{
+		detail::deallocate_hinted_fixed<
+			base::is_array_allocation::value, 
+			sizeof(value_type) * nCount
+		>(this->get_hinted_module_ops(eHint), p);
 	}
 };
 
@@ -480,12 +936,29 @@ class modulebound_allocator<void, RawAllocation>:
 {
 	typedef modulebound_allocator_base<void, RawAllocation> base;
 
+public:
+	typedef void value_type;
+	typedef void* pointer;
+	typedef const void* const_pointer;
+
 
 public:
 	modulebound_allocator() throw(): 
 		base()
 	{}
 
+	/**	@short	Bind to the current module ignoring an active region
+	 */
+	explicit modulebound_allocator(ignore_region_t tag) throw(): 
+		base(tag)
+	{}
+
+	/**	@short	Bind to the table @e pModuleOps
+	 */
+	explicit modulebound_allocator(const module_ops* pModuleOps) throw(): 
+		base(pModuleOps)
+	{}
+
 	// c++0x
 	//~modulebound_allocator() throw() = default;
 	//modulebound_allocator(const modulebound_allocator& rOther) throw() = default;
@@ -509,7 +982,18 @@ public:
 		return *this;
 	}
 
-#if (_MSC_VER >= 1600)	// move semantics
+#if (_MSC_VER >= 1600) || (__cplusplus >= 201103L)	// move semantics
+	// declaring the move constructor suppresses the implicit copy operations
+	modulebound_allocator(const modulebound_allocator& rOther) throw(): 
+		base(rOther)
+	{}
+
+	modulebound_allocator& operator =(const modulebound_allocator& rOther) throw()
+	{
+		base::operator =(rOther);
+		return *this;
+	}
+
 	/**	@short	Move construct from other modulebound_allocators
 	 */
 	modulebound_allocator(const modulebound_allocator&& rOther) throw()
@@ -538,33 +1022,33 @@ public:
 	template<typename U, typename RawAllocationU>
 	modulebound_allocator& operator =(const modulebound_allocator<U, RawAllocationU>&& rOther) throw()
 	{
-		base::operator =(std::move(Other));
+		base::operator =(std::move(rOther));
 		return *this;
 	}
 #endif
 };
 
 
-/**	@short	Test for allocator equality - raw allocation functions must be the same
+/**	@short	Test for allocator equality - raw allocation functions must be built 
+			on the same heap
 			(storage allocated from each can be deallocated via the other)
  */
 template<typename T, typename RawAllocation, typename U, typename RawAllocationU> inline
 bool operator ==(const modulebound_allocator<T, RawAllocation>& rLeft, 
 				 const modulebound_allocator<U, RawAllocationU>& rRight) throw()
 {
-	// compare raw allocation functions pair (forwarding to pair comparison operator)
-	return rLeft.get_raw_operators() == rRight.get_raw_operators();
+	return rLeft.get_module_ops()->heap == rRight.get_module_ops()->heap;
 }
 
-/**	@short	Test for allocator inequality - raw allocation functions must be the same
+/**	@short	Test for allocator inequality - raw allocation functions must be built 
+			on the same heap
 			(storage allocated from each can't be deallocated via the other)
  */
 template<typename T, typename RawAllocation, typename U, typename RawAllocationU> inline
 bool operator !=(const modulebound_allocator<T, RawAllocation>& rLeft, 
 				 const modulebound_allocator<U, RawAllocationU>& rRight) throw()
 {
-	// compare raw allocation functions pair (forwarding to pair comparison operator)
-	return rLeft.get_raw_operators() != rRight.get_raw_operators();
+	return !(rLeft == rRight);
 }
 
 
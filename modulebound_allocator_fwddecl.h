@@ -16,12 +16,19 @@
 namespace kj
 {
 
+struct module_ops;
+
+
 #ifdef _MSC_VER	// msvc declares operator new/operator delete with __cdecl calling convension
 
 ///	function pointer type for raw memory allocation functions
 typedef void* (__cdecl *fp_raw_allocate_t)(size_t);
 ///	function pointer type for raw memory deallocation functions
 typedef void (__cdecl *fp_raw_deallocate_t)(void*);
+///	function pointer type for allocation functions of a module_ops table
+typedef void* (__cdecl *fp_ops_allocate_t)(const module_ops*, size_t);
+///	function pointer type for deallocation functions of a module_ops table
+typedef void (__cdecl *fp_ops_deallocate_t)(const module_ops*, void*, size_t);
 
 #else	// use default for other compilers
 
@@ -29,10 +36,64 @@ typedef void (__cdecl *fp_raw_deallocate_t)(void*);
 typedef void* (*fp_raw_allocate_t)(size_t);
 ///	function pointer type for raw memory deallocation functions
 typedef void (*fp_raw_deallocate_t)(void*);
+///	function pointer type for allocation functions of a module_ops table
+typedef void* (*fp_ops_allocate_t)(const module_ops*, size_t);
+///	function pointer type for deallocation functions of a module_ops table
+typedef void (*fp_ops_deallocate_t)(const module_ops*, void*, size_t);
 
 #endif
 
 
+/**	@short	Table of a module's raw memory operations.
+
+	A plain structure with a fixed layout, which lets code built with 
+	different compilers or compiler flags call back into the module that 
+	owns a block of memory.
+ */
+struct module_ops
+{
+	///	raw allocation function of the module
+	fp_raw_allocate_t allocate;
+	///	raw deallocation function of the module
+	fp_raw_deallocate_t deallocate;
+	///	identifies the heap the raw functions are built on; 
+	///	blocks may be freed through any table referring to the same heap
+	const void* heap;
+	///	allocation function used by the module-bound allocator; 
+	///	receives the table itself, so a table embedded in some allocation 
+	///	state (e.g. a region) can reach that state
+	fp_ops_allocate_t ops_allocate;
+	///	deallocation function used by the module-bound allocator; 
+	///	receives the table itself and the number of bytes originally requested
+	fp_ops_deallocate_t ops_deallocate;
+	///	copies and conversions of an allocator bound to this table keep it, 
+	///	instead of capturing the current module's table; 
+	///	set by tables managing storage of their own (e.g. a region)
+	bool keep_on_copy;
+	///	tables for blocks allocated with the hint::hot and hint::cold hints, 
+	///	0 if hints are ignored
+	const module_ops* hot;
+	const module_ops* cold;
+};
+
+
+namespace hint
+{
+
+/**	@short	Access frequency hints for the module-bound allocator.
+	Blocks allocated with a hint must be deallocated with the same hint.
+ */
+enum temperature
+{
+	///	frequently accessed, packed together with other hot blocks
+	hot = 0, 
+	///	rarely accessed (e.g. error strings), kept away from hot blocks
+	cold = 1
+};
+
+}	// namespace hint
+
+
 
 /**	@short	Named constants telling us whether to use the raw allocation 
 	functions for an array of objects or for single objects 
@@ -71,6 +132,18 @@ enum raw_allocation_type
 };
 
 
+/**	@short	Supplies the table of raw memory operations for an allocation mode.
+
+	The default allocation modes are the @c raw_allocation_type constants 
+	wrapped in a @c std::integral_constant. Custom allocation modes derive 
+	from such a constant and specialize this traits class; they are passed 
+	to the module-bound allocator as @c RawAllocation and are preserved when 
+	rebinding.
+ */
+template<typename RawAllocation, typename T>
+struct allocation_mode_traits;
+
+
 #if 0	// c++0x (template aliases)
 template<raw_allocation_type C>
 using raw_allocation_variant =	std::integral_constant<
@@ -0,0 +1,230 @@
+/**	@file	Owned memory buffer handed between modules without copying.
+
+	@date	2026 10 17	kj	created
+ */
+
+#ifndef KJ_MODULEBOUND_BUFFER_H_INCLUDED
+#define KJ_MODULEBOUND_BUFFER_H_INCLUDED
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#  pragma once
+#endif
+
+#include <vector>
+#include <utility>	// std::move, std::swap
+#include "modulebound_allocator.h"
+
+
+namespace kj
+{
+
+/**	@short	Move-only span owning a contiguous sequence of @c T allocated
+	through the module-bound array allocator.
+
+	The storage's allocator travels with the storage, so a plugin can hand a
+	payload over to the host (or vice versa) and the storage is freed in the
+	originating module wherever the buffer is finally destroyed.
+
+	Adoption from and release to a @c std::vector<T, modulebound_allocator<T[]> >
+	is O(1): the vector's storage changes hands together with its allocator,
+	which is moved (not re-captured) and therefore keeps the raw operators of
+	the originating module.
+	A vector's allocator can't be inspected without copying it, which binds
+	the copy to the copying module; so the buffer records the table of the
+	originating module itself: that of the module creating the storage, or of
+	the module adopting a vector. Adopt vectors in the module that allocated
+	them (or bound them to a region), as in the example below.
+
+	@code
+	// plugin
+	kj::module_buffer<float> produce()
+	{
+		kj::module_buffer<float>::vector_type samples;
+		fill(samples);
+		return kj::module_buffer<float>(std::move(samples));
+	}
+
+	// host
+	kj::module_buffer<float> payload = plugin->produce();
+	consume(payload.data(), payload.size());
+	@endcode
+ */
+template<typename T>
+class module_buffer
+{
+public:
+	typedef std::vector<T, modulebound_allocator<T[]> > vector_type;
+	typedef typename vector_type::allocator_type allocator_type;
+	typedef T value_type;
+	typedef size_t size_type;
+	typedef T* pointer;
+	typedef const T* const_pointer;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef T* iterator;
+	typedef const T* const_iterator;
+
+
+private:
+	// owns the storage
+	vector_type m_storage;
+	// table of the storage's originating module
+	const module_ops* m_pOps;
+
+	// noncopyable
+	module_buffer(const module_buffer&);
+	module_buffer& operator =(const module_buffer&);
+
+public:
+	/**	@short	Construct an empty buffer
+	 */
+	module_buffer() throw():
+		m_storage(),
+		m_pOps(allocator_type().get_module_ops())
+	{}
+
+	/**	@short	Allocate @e nCount value-initialized elements in the current module
+		@throw	@c std::bad_alloc
+	 */
+	explicit module_buffer(size_type nCount):
+		m_storage(nCount),
+		m_pOps(allocator_type().get_module_ops())
+	{}
+
+	/**	@short	Adopt the storage of @e rVector in O(1), leaving @e rVector empty
+	 */
+	explicit module_buffer(vector_type&& rVector) throw():
+		m_storage(std::move(rVector)),
+		m_pOps(m_storage.get_allocator().get_module_ops())
+	{}
+
+	/**	@short	Take over the storage of @e rOther, leaving @e rOther empty
+	 */
+	module_buffer(module_buffer&& rOther) throw():
+		m_storage(std::move(rOther.m_storage)),
+		m_pOps(rOther.m_pOps)
+	{}
+
+	/**	@short	Free the current storage in its originating module and
+		take over the storage of @e rOther
+	 */
+	module_buffer& operator =(module_buffer&& rOther) throw()
+	{
+		if (this != &rOther)
+		{
+			m_storage = std::move(rOther.m_storage);
+			m_pOps = rOther.m_pOps;
+		}
+
+		return *this;
+	}
+
+	/**	@short	Free the current storage in its originating module and
+		adopt the storage of @e rVector in O(1)
+	 */
+	module_buffer& operator =(vector_type&& rVector) throw()
+	{
+		m_storage = std::move(rVector);
+		m_pOps = m_storage.get_allocator().get_module_ops();
+		return *this;
+	}
+
+	/**	@short	Hand the storage over to a vector in O(1), leaving the buffer empty
+	 */
+	vector_type release() throw()
+	{
+		vector_type storage(std::move(m_storage));
+		return storage;
+	}
+
+	/**	@short	Exchange the storage (and the originating modules) of two buffers
+	 */
+	void swap(module_buffer& rOther) throw()
+	{
+		m_storage.swap(rOther.m_storage);
+		std::swap(m_pOps, rOther.m_pOps);
+	}
+
+	/**	@short	An allocator bound to the storage's originating module
+		@note	Copies of it capture the copying module, like any allocator copy.
+	 */
+	allocator_type get_allocator() const throw()
+	{
+		return allocator_type(m_pOps);
+	}
+
+	/**	@short	The raw deallocation function of the storage's originating module
+	 */
+	fp_raw_deallocate_t get_raw_deallocate() const throw()
+	{
+		return m_pOps->deallocate;
+	}
+
+	pointer data() throw()
+	{
+		return m_storage.data();
+	}
+
+	const_pointer data() const throw()
+	{
+		return m_storage.data();
+	}
+
+	size_type size() const throw()
+	{
+		return m_storage.size();
+	}
+
+	size_type capacity() const throw()
+	{
+		return m_storage.capacity();
+	}
+
+	bool empty() const throw()
+	{
+		return m_storage.empty();
+	}
+
+	iterator begin() throw()
+	{
+		return m_storage.data();
+	}
+
+	const_iterator begin() const throw()
+	{
+		return m_storage.data();
+	}
+
+	iterator end() throw()
+	{
+		return m_storage.data() + m_storage.size();
+	}
+
+	const_iterator end() const throw()
+	{
+		return m_storage.data() + m_storage.size();
+	}
+
+	reference operator [](size_type i) throw()
+	{
+		return m_storage[i];
+	}
+
+	const_reference operator [](size_type i) const throw()
+	{
+		return m_storage[i];
+	}
+};
+
+
+template<typename T> inline
+void swap(module_buffer<T>& rLeft, module_buffer<T>& rRight) throw()
+{
+	rLeft.swap(rRight);
+}
+
+
+}	// namespace kj
+
+
+#endif	// file guard
@@ -0,0 +1,311 @@
+/**	@file	C interface to module-bound memory, for plugins written in C.
+
+	@c kj_module_malloc() allocates through the raw operations of the calling
+	module (in C++ the table of @c kj::detail::fetch_raw_operators(), in C the
+	c runtime the module is linked against) and records them in front of the
+	block. @c kj_module_free() and @c kj_module_realloc() go through the
+	recorded operations, so a block may be handed between C and C++ code of
+	any module without copying and is always freed by the module that
+	allocated it.
+
+	The header compiles as C (C89 or later) and as C++; the functions have
+	internal linkage and are thus bound to the module including the header.
+
+	@code
+	// C++ host, hands a buffer to a C plugin taking ownership
+	kj::modulebound_allocator<char, kj::c_block_allocation<> > allocator;
+	char* pBuffer = allocator.allocate(nBytes);
+	plugin_consume(pBuffer);	// calls kj_module_free(pBuffer) when done
+
+	// C plugin, returns a buffer to the host
+	char* pszResult = (char*) kj_module_malloc(nLength + 1);
+	@endcode
+
+	C++ code deallocates blocks from @c kj_module_malloc() with an allocator
+	of the @c kj::c_block_allocation mode, or with @c kj_module_free().
+
+	@date	2026 10 17	kj	created
+ */
+
+#ifndef KJ_MODULEBOUND_C_H_INCLUDED
+#define KJ_MODULEBOUND_C_H_INCLUDED
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#  pragma once
+#endif
+
+#include <stddef.h>
+#include <string.h>	/* memcpy */
+#ifdef __cplusplus
+#  include <type_traits>
+#  include <new>	/* std::bad_alloc */
+#  include "modulebound_allocator.h"
+#else
+#  include <stdlib.h>	/* malloc, free */
+#endif
+
+
+#ifdef _MSC_VER	/* msvc declares the c runtime functions with __cdecl calling convension */
+#  define KJ_MODULEBOUND_CDECL __cdecl
+#else
+#  define KJ_MODULEBOUND_CDECL
+#endif
+
+/* bound to the including module: internal linkage */
+#if defined(__cplusplus) || (defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L)
+#  define KJ_MODULEBOUND_C_API static inline
+#elif defined(_MSC_VER)
+#  define KJ_MODULEBOUND_C_API static __inline
+#elif defined(__GNUC__)
+#  define KJ_MODULEBOUND_C_API static __inline__
+#else
+#  define KJ_MODULEBOUND_C_API static
+#endif
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**	function pointer type for the allocation function recorded in a block;
+	returns 0 on failure, never throws
+ */
+typedef void* (KJ_MODULEBOUND_CDECL *kj_module_allocate_fn)(size_t);
+/**	function pointer type for the deallocation function recorded in a block */
+typedef void (KJ_MODULEBOUND_CDECL *kj_module_free_fn)(void*);
+
+/**	@short	Precedes every block of @c kj_module_malloc().
+
+	Part of the interface between modules - don't reorder or add members.
+ */
+typedef union kj_module_block_header
+{
+	struct
+	{
+		/** allocation function of the owning module, used by @c kj_module_realloc() */
+		kj_module_allocate_fn m_pfnAllocate;
+		/** deallocation function of the owning module */
+		kj_module_free_fn m_pfnFree;
+		/** size requested by the user */
+		size_t m_nBytes;
+	} m_owner;
+	/* align the user's part like malloc does */
+	long double m_dAlign;
+	double m_fAlign;
+	void* m_pAlign;
+} kj_module_block_header;
+
+#ifdef __cplusplus
+}	/* extern "C" */
+
+
+namespace kj
+{
+
+namespace detail
+{
+
+// the non-throwing allocation function of this module recorded in blocks
+inline
+void* KJ_MODULEBOUND_CDECL c_block_raw_allocate(size_t nBytes) throw()
+{
+	try
+	{
+		return fetch_raw_operators(true).first(nBytes);
+	}
+	catch (const std::bad_alloc&)
+	{
+		return 0;
+	}
+}
+
+}	// namespace detail
+
+}	// namespace kj
+
+
+extern "C"
+{
+#endif
+
+/**	@short	Record the raw operations of the current module in @e pHeader.
+ */
+KJ_MODULEBOUND_C_API void kj_module_block_own(kj_module_block_header* pHeader)
+{
+#ifdef __cplusplus
+	pHeader->m_owner.m_pfnAllocate = &kj::detail::c_block_raw_allocate;
+	pHeader->m_owner.m_pfnFree = kj::detail::fetch_raw_operators(true).second;
+#else
+	pHeader->m_owner.m_pfnAllocate = &malloc;
+	pHeader->m_owner.m_pfnFree = &free;
+#endif
+}
+
+/**	@short	Allocate @e nBytes with the raw operations of the current module.
+	@return	The block, 0 if memory is exhausted
+ */
+KJ_MODULEBOUND_C_API void* kj_module_malloc(size_t nBytes)
+{
+	kj_module_block_header header;
+	kj_module_block_header* pHeader;
+
+	if (nBytes > (size_t) -1 - sizeof(kj_module_block_header))
+		return 0;
+	kj_module_block_own(&header);
+	pHeader = (kj_module_block_header*) header.m_owner.m_pfnAllocate(sizeof(kj_module_block_header) + nBytes);
+	if (!pHeader)
+		return 0;
+	header.m_owner.m_nBytes = nBytes;
+	*pHeader = header;
+	return pHeader + 1;
+}
+
+/**	@short	Free the block at @e p (may be 0) in the module that allocated it.
+ */
+KJ_MODULEBOUND_C_API void kj_module_free(void* p)
+{
+	kj_module_block_header* pHeader;
+
+	if (!p)
+		return;
+	pHeader = (kj_module_block_header*) p - 1;
+	pHeader->m_owner.m_pfnFree(pHeader);
+}
+
+/**	@short	Size requested for the block at @e p.
+ */
+KJ_MODULEBOUND_C_API size_t kj_module_block_size(const void* p)
+{
+	return p ? ((const kj_module_block_header*) p - 1)->m_owner.m_nBytes : 0;
+}
+
+/**	@short	Resize the block at @e p to @e nBytes.
+
+	The new block belongs to the same module as the old one, no matter which
+	module resizes it. As with @c realloc, a null @e p allocates in the
+	current module, and on failure the old block is left untouched.
+	@return	The new block, 0 if memory is exhausted or @e nBytes is 0
+		(which frees the block)
+ */
+KJ_MODULEBOUND_C_API void* kj_module_realloc(void* p, size_t nBytes)
+{
+	kj_module_block_header* pHeader;
+	kj_module_block_header* pNewHeader;
+
+	if (!p)
+		return kj_module_malloc(nBytes);
+	if (!nBytes)
+	{
+		kj_module_free(p);
+		return 0;
+	}
+	if (nBytes > (size_t) -1 - sizeof(kj_module_block_header))
+		return 0;
+
+	pHeader = (kj_module_block_header*) p - 1;
+	pNewHeader = (kj_module_block_header*) pHeader->m_owner.m_pfnAllocate(sizeof(kj_module_block_header) + nBytes);
+	if (!pNewHeader)
+		return 0;
+	*pNewHeader = *pHeader;
+	pNewHeader->m_owner.m_nBytes = nBytes;
+	memcpy(pNewHeader + 1, p, nBytes < pHeader->m_owner.m_nBytes ? nBytes : pHeader->m_owner.m_nBytes);
+	pHeader->m_owner.m_pfnFree(pHeader);
+	return pNewHeader + 1;
+}
+
+#ifdef __cplusplus
+}	/* extern "C" */
+
+
+namespace kj
+{
+
+/**	@short	Allocation mode exchanging blocks with C code: allocators of the
+	mode allocate with @c kj_module_malloc() and deallocate with
+	@c kj_module_free().
+
+	Blocks thus travel between the mode's allocators and C code in either
+	direction, and are freed by the module that allocated them. Allocators of
+	the mode ignore an active region (see modulebound_region.h).
+
+	The allocation mode is passed as the @c RawAllocation parameter and is
+	preserved when rebinding; @c C is only kept for rebinding, blocks are
+	always allocated with the array operators.
+ */
+template<raw_allocation_type C = raw_allocation_single>
+struct c_block_allocation: std::integral_constant<raw_allocation_type, C>
+{};
+
+
+namespace detail
+{
+
+struct c_block_ops
+{
+	static void* raw_allocate(size_t nBytes)
+	{
+		if (void* p = kj_module_malloc(nBytes))
+			return p;
+		throw std::bad_alloc();
+	}
+
+	static void raw_deallocate(void* p) throw()
+	{
+		kj_module_free(p);
+	}
+
+	static void* ops_allocate(const module_ops*, size_t nBytes)
+	{
+		return raw_allocate(nBytes);
+	}
+
+	static void ops_deallocate(const module_ops*, void* p, size_t) throw()
+	{
+		kj_module_free(p);
+	}
+
+	static const module_ops* fetch() throw()
+	{
+		// blocks carry a header, so they are distinct from plain heap blocks
+		static const module_ops s_ops =
+		{
+			&raw_allocate,
+			&raw_deallocate,
+			&s_ops,
+			&ops_allocate, &ops_deallocate,
+			false,
+			0, 0
+		};
+
+		return &s_ops;
+	}
+};
+
+}	// namespace detail
+
+
+/**	@short	C block allocation mode binds allocators to the C interface of
+	the current module
+ */
+template<raw_allocation_type C, typename T>
+struct allocation_mode_traits<c_block_allocation<C>, T>
+{
+	static const module_ops* fetch_module_ops(bool) throw()
+	{
+		return detail::c_block_ops::fetch();
+	}
+};
+
+/**	@short	C code reads the header in front of the blocks, so allocators of
+	the C block allocation mode never allocate from a region
+ */
+template<raw_allocation_type C>
+struct allocation_mode_ignores_region<c_block_allocation<C> >: std::true_type
+{};
+
+}	// namespace kj
+#endif	/* __cplusplus */
+
+
+#endif	/* file guard */
@@ -0,0 +1,440 @@
+/**	@file	Compacting relocation of module-bound node containers.
+
+	After a long uptime the nodes of a list or map are scattered across the
+	heap. Compacting rebuilds the container in iteration order into arena
+	chunks of the current module, so iterating walks memory sequentially
+	again; the old nodes are freed.
+
+	@code
+	// index: std::map<key, value, std::less<key>, kj::modulebound_allocator<std::pair<const key, value> > >
+	kj::compact(index);
+	@endcode
+
+	@date	2026 10 17	kj	created
+ */
+
+#ifndef KJ_MODULEBOUND_COMPACT_H_INCLUDED
+#define KJ_MODULEBOUND_COMPACT_H_INCLUDED
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#  pragma once
+#endif
+
+#include <type_traits>
+#include <utility>	// std::move_if_noexcept
+#include <algorithm>	// std::upper_bound
+#include <functional>	// std::less
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <new>
+#include <cstddef>	// std::max_align_t
+#include <stddef.h>
+#include "modulebound_allocator.h"
+#include "modulebound_lifecycle.h"
+
+
+namespace kj
+{
+
+namespace detail
+{
+
+// header of an arena chunk, followed by the blocks
+struct compact_chunk
+{
+	char* m_pEnd;
+	// blocks allocated (updated by the compacting thread only) and freed
+	ptrdiff_t m_nAllocated;
+	ptrdiff_t m_nFreed;
+	// still being filled by a compaction
+	bool m_bFilling;
+	// next chunk filled by the same compaction
+	compact_chunk* m_pNext;
+};
+
+const size_t compact_alignment = alignof(std::max_align_t);
+const size_t compact_header_size = (sizeof(compact_chunk) + compact_alignment - 1) & ~(compact_alignment - 1);
+const size_t compact_min_chunk_size = 4096;
+
+
+/**	@short	Per-module registry of the arena chunks, finds the chunk a freed
+	block belongs to.
+
+	The registry is never destroyed, so blocks freed during static
+	destruction find it intact; its bookkeeping storage is given back at
+	module exit if no chunk is left.
+ */
+class compaction_registry
+{
+	std::mutex m_mutex;
+	// sorted by address
+	std::vector<compact_chunk*> m_chunks;
+	std::atomic<size_t> m_nChunks;
+
+	compaction_registry() throw():
+		m_nChunks(0)
+	{}
+
+	struct closer
+	{
+		compaction_registry& m_rRegistry;
+
+		explicit closer(compaction_registry& rRegistry) throw():
+			m_rRegistry(rRegistry)
+		{}
+
+		~closer() throw()
+		{
+			std::lock_guard<std::mutex> lock(m_rRegistry.m_mutex);
+			if (m_rRegistry.m_chunks.empty())
+				std::vector<compact_chunk*>().swap(m_rRegistry.m_chunks);
+		}
+	};
+
+	static void free_chunk(compact_chunk* pChunk) throw()
+	{
+		fetch_module_ops(true)->deallocate(pChunk);
+	}
+
+	// the chunk holding p, or end of m_chunks
+	std::vector<compact_chunk*>::iterator find(void* p) throw()
+	{
+		std::vector<compact_chunk*>::iterator it = std::upper_bound(
+			m_chunks.begin(), m_chunks.end(), static_cast<compact_chunk*>(p), std::less<compact_chunk*>()
+		);
+		if (it == m_chunks.begin())
+			return m_chunks.end();
+		--it;
+		return std::less<void*>()(p, (*it)->m_pEnd) ? it : m_chunks.end();
+	}
+
+	void erase(std::vector<compact_chunk*>::iterator it) throw()
+	{
+		compact_chunk* pChunk = *it;
+		m_chunks.erase(it);
+		m_nChunks.store(m_chunks.size(), std::memory_order_relaxed);
+		free_chunk(pChunk);
+	}
+
+public:
+	///	The registry of the current module
+	static compaction_registry& instance()
+	{
+		static std::aligned_storage<sizeof(compaction_registry), alignof(compaction_registry)>::type s_storage;
+		static compaction_registry* s_pRegistry = ::new (static_cast<void*>(&s_storage)) compaction_registry();
+		static closer s_closer(*s_pRegistry);
+		register_fork_handlers<&lock_registry, &unlock_registry, &unlock_registry>();
+		return *s_pRegistry;
+	}
+
+	static void lock_registry()
+	{
+		instance().m_mutex.lock();
+	}
+
+	static void unlock_registry()
+	{
+		instance().m_mutex.unlock();
+	}
+
+	/**	@short	Allocate and register a chunk for @e nBytes
+		@return	0 if out of memory
+	 */
+	compact_chunk* add(size_t nBytes) throw()
+	{
+		void* p = ::operator new[](compact_header_size + nBytes, std::nothrow);
+		if (!p)
+			return 0;
+
+		// chunks are freed through the module's raw operators
+		compact_chunk* pChunk = static_cast<compact_chunk*>(p);
+		pChunk->m_pEnd = static_cast<char*>(p) + compact_header_size + nBytes;
+		pChunk->m_nAllocated = 0;
+		pChunk->m_nFreed = 0;
+		pChunk->m_bFilling = true;
+		pChunk->m_pNext = 0;
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		try
+		{
+			m_chunks.insert(
+				std::upper_bound(m_chunks.begin(), m_chunks.end(), pChunk, std::less<compact_chunk*>()),
+				pChunk
+			);
+		}
+		catch (...)
+		{
+			free_chunk(pChunk);
+			return 0;
+		}
+		m_nChunks.store(m_chunks.size(), std::memory_order_relaxed);
+
+		return pChunk;
+	}
+
+	/**	@short	Account for a freed block, free its chunk if it's empty
+		@return	false if @e p isn't in a chunk
+	 */
+	bool release(void* p) throw()
+	{
+		if (!m_nChunks.load(std::memory_order_relaxed))
+			return false;
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		std::vector<compact_chunk*>::iterator it = find(p);
+		if (it == m_chunks.end())
+			return false;
+
+		compact_chunk* pChunk = *it;
+		++pChunk->m_nFreed;
+		if (!pChunk->m_bFilling && pChunk->m_nFreed == pChunk->m_nAllocated)
+			erase(it);
+		return true;
+	}
+
+	///	End filling a chunk, free it if it's empty
+	void finish(compact_chunk* pChunk) throw()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		pChunk->m_bFilling = false;
+		if (pChunk->m_nFreed == pChunk->m_nAllocated)
+			erase(find(pChunk));
+	}
+};
+
+
+// state of the compaction running on a thread
+class compaction_target
+{
+	size_t m_nBudget;
+	compact_chunk* m_pFilled;
+	char* m_pCursor;
+	char* m_pEnd;
+
+	// noncopyable
+	compaction_target(const compaction_target&);
+	compaction_target& operator =(const compaction_target&);
+
+public:
+	/**	@param	nBudget	estimated number of bytes the container needs
+	 */
+	explicit compaction_target(size_t nBudget) throw():
+		m_nBudget(nBudget),
+		m_pFilled(0),
+		m_pCursor(0),
+		m_pEnd(0)
+	{}
+
+	~compaction_target() throw()
+	{
+		while (compact_chunk* pChunk = m_pFilled)
+		{
+			m_pFilled = pChunk->m_pNext;
+			compaction_registry::instance().finish(pChunk);
+		}
+	}
+
+	/**	@short	Allocate a block from the arena
+		@return	0 if the block should come from the heap
+	 */
+	void* allocate(size_t nBytes) throw()
+	{
+		nBytes = (nBytes + compact_alignment - 1) & ~(compact_alignment - 1);
+
+		if (size_t(m_pEnd - m_pCursor) < nBytes)
+		{
+			const size_t nChunkSize = m_nBudget < compact_min_chunk_size ? compact_min_chunk_size : m_nBudget;
+			if (nBytes > nChunkSize / 4)
+				return 0;
+
+			compact_chunk* pChunk = compaction_registry::instance().add(nChunkSize);
+			if (!pChunk)
+				return 0;
+			pChunk->m_pNext = m_pFilled;
+			m_pFilled = pChunk;
+			m_pCursor = reinterpret_cast<char*>(pChunk) + compact_header_size;
+			m_pEnd = pChunk->m_pEnd;
+
+			// the estimate fell short, further chunks get smaller
+			m_nBudget = nChunkSize / 2;
+		}
+
+		void* p = m_pCursor;
+		m_pCursor += nBytes;
+		++m_pFilled->m_nAllocated;
+		return p;
+	}
+};
+
+// the compaction running on the calling thread, if any
+inline
+compaction_target*& current_compaction() throw()
+{
+	static thread_local compaction_target* s_pTarget = 0;
+	return s_pTarget;
+}
+
+
+// raw memory operations of compacted containers: allocate from the running
+// compaction's arena or from the heap, free to the arena chunk or to the heap
+struct compaction_ops
+{
+	static void* allocate(size_t nBytes)
+	{
+		if (compaction_target* pTarget = current_compaction())
+			if (void* p = pTarget->allocate(nBytes))
+				return p;
+		return fetch_module_ops(true)->allocate(nBytes);
+	}
+
+	static void deallocate(void* p)
+	{
+		if (!compaction_registry::instance().release(p))
+			fetch_module_ops(true)->deallocate(p);
+	}
+
+	static void* ops_allocate(const module_ops*, size_t nBytes)
+	{
+		return allocate(nBytes);
+	}
+
+	static void ops_deallocate(const module_ops*, void* p, size_t) throw()
+	{
+		deallocate(p);
+	}
+
+	static const module_ops* fetch() throw()
+	{
+		static const module_ops s_ops =
+		{
+			&allocate,
+			&deallocate,
+			&s_ops,
+			&ops_allocate,
+			&ops_deallocate,
+			// rebound allocators must free arena blocks through the registry
+			true,
+			// compacted containers ignore hints
+			0,
+			0
+		};
+
+		return &s_ops;
+	}
+};
+
+
+// makes allocators constructed on the calling thread allocate from a new compaction arena
+class compaction_scope
+{
+	compaction_target m_target;
+	compaction_target* m_pPreviousTarget;
+	const module_ops** m_ppSlot;
+	const module_ops* m_pPreviousOps;
+
+	// noncopyable
+	compaction_scope(const compaction_scope&);
+	compaction_scope& operator =(const compaction_scope&);
+
+public:
+	explicit compaction_scope(size_t nBudget) throw():
+		m_target(nBudget),
+		m_pPreviousTarget(current_compaction()),
+		m_ppSlot(region_slot_accessor()()),
+		m_pPreviousOps(*m_ppSlot)
+	{
+		current_compaction() = &m_target;
+		*m_ppSlot = compaction_ops::fetch();
+	}
+
+	~compaction_scope() throw()
+	{
+		*m_ppSlot = m_pPreviousOps;
+		current_compaction() = m_pPreviousTarget;
+	}
+};
+
+
+// metafunctions telling whether T is an ordered or a hashed associative container
+template<typename T>
+struct has_key_compare
+{
+	template<typename U> static char test(typename U::key_compare*);
+	template<typename U> static long test(...);
+
+	static const bool value = sizeof(test<T>(0)) == sizeof(char);
+};
+
+template<typename T>
+struct has_hasher
+{
+	template<typename U> static char test(typename U::hasher*);
+	template<typename U> static long test(...);
+
+	static const bool value = sizeof(test<T>(0)) == sizeof(char);
+};
+
+// empty container with the ordering or hashing of rContainer
+template<typename Container> inline
+typename std::enable_if<has_key_compare<Container>::value, Container>::type
+make_empty_like(const Container& rContainer, const typename Container::allocator_type& rAllocator)
+{
+	return Container(rContainer.key_comp(), rAllocator);
+}
+
+template<typename Container> inline
+typename std::enable_if<has_hasher<Container>::value, Container>::type
+make_empty_like(const Container& rContainer, const typename Container::allocator_type& rAllocator)
+{
+	return Container(rContainer.bucket_count(), rContainer.hash_function(), rContainer.key_eq(), rAllocator);
+}
+
+template<typename Container> inline
+typename std::enable_if<!has_key_compare<Container>::value && !has_hasher<Container>::value, Container>::type
+make_empty_like(const Container& /*rContainer*/, const typename Container::allocator_type& rAllocator)
+{
+	return Container(rAllocator);
+}
+
+}	// namespace detail
+
+
+/**	@short	Rebuild a node container using the module-bound allocator in
+	iteration order into arena chunks of the current module.
+
+	The elements are moved if that can't throw, copied otherwise. If an
+	exception is thrown (e.g. @c std::bad_alloc while inserting), the
+	container keeps all its elements, but those already moved are left in
+	their moved-from state; only elements that are copied stay unchanged.
+	An arena chunk is freed once all its blocks are freed; blocks allocated
+	by the container after compacting come from the heap.
+
+	@attention	Meant for node containers (lists, sets, maps); blocks larger
+	than a quarter of a chunk (e.g. the storage of a vector) stay on the heap.
+	Freeing a block of a compacted container looks up the chunk it belongs to
+	under a lock of the current module as long as any arena chunk exists.
+	@throw	@c std::bad_alloc, or any exception thrown by the elements' constructors
+ */
+template<typename Container> inline
+typename std::enable_if<detail::is_modulebound_container<Container>::value>::type
+compact(Container& rContainer)
+{
+	// node estimate: element and a few links
+	const size_t nNodeSize = sizeof(typename Container::value_type) + 4 * sizeof(void*);
+	detail::compaction_scope scope(rContainer.size() * nNodeSize);
+
+	// captures the compaction's arena
+	const typename Container::allocator_type target;
+	Container compacted(detail::make_empty_like(rContainer, target));
+	for (typename Container::iterator it = rContainer.begin(); it != rContainer.end(); ++it)
+		compacted.insert(compacted.end(), std::move_if_noexcept(*it));
+
+	rContainer = std::move(compacted);
+}
+
+
+}	// namespace kj
+
+
+#endif	// file guard
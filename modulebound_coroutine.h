@@ -0,0 +1,261 @@
+/**	@file	Module-bound allocation of coroutine frames.
+
+	Coroutine promise types deriving from @c kj::modulebound_promise get
+	their frames from a pool of the module creating the coroutine. Each frame
+	remembers the module's table, so destroying the coroutine returns the frame
+	to that module's pool, even if the coroutine is resumed and destroyed on an
+	executor of another module.
+
+	@code
+	struct task
+	{
+		struct promise_type: kj::modulebound_promise<>
+		{
+			task get_return_object();
+			std::suspend_always initial_suspend() noexcept;
+			...
+		};
+	};
+	@endcode
+
+	The mixin only declares class-specific @c operator @c new and
+	@c operator @c delete, so the header itself doesn't require C++20.
+
+	@date	2026 10 17	kj	created
+ */
+
+#ifndef KJ_MODULEBOUND_COROUTINE_H_INCLUDED
+#define KJ_MODULEBOUND_COROUTINE_H_INCLUDED
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#  pragma once
+#endif
+
+#include <type_traits>
+#include <atomic>
+#include <new>
+#include <cstddef>	// std::max_align_t
+#include <stddef.h>
+#include "modulebound_allocator.h"
+#include "modulebound_pool.h"
+#include "modulebound_lockfree.h"
+#include "modulebound_lifecycle.h"
+
+
+namespace kj
+{
+
+/**	@short	Allocation mode recycling up to @c Depth coroutine frames per
+	size class in the module creating the coroutines.
+
+	The size classes are those of the module-bound pools (multiples of 16
+	bytes up to 1 KiB, or the generated classes), which suit the small frames
+	of short coroutines better than the power-of-two classes of
+	@c recycling_allocation. Larger frames come from the heap directly.
+	Rings are lock-free, so frames may be freed on any thread.
+
+	The allocation mode is passed as the @c RawAllocation parameter of
+	@c modulebound_promise, but like any allocation mode it also serves
+	@c modulebound_allocator.
+ */
+template<size_t Depth = 32>
+struct frame_pool_allocation: std::integral_constant<raw_allocation_type, raw_allocation_single>
+{};
+
+
+namespace detail
+{
+
+/**	@short	Per-module pool of freed coroutine frames, one bounded ring per
+	size class of the module-bound pools.
+
+	Like the recycling pool it is never destroyed, closing it at module exit
+	gives the cached frames back to the heap.
+ */
+template<size_t Depth>
+class frame_pool
+{
+	bounded_pointer_ring<Depth> m_rings[pool_class_count];
+	std::atomic<bool> m_bClosed;
+
+	frame_pool() throw():
+		m_bClosed(false)
+	{}
+
+	struct closer
+	{
+		frame_pool& m_rPool;
+
+		explicit closer(frame_pool& rPool) throw():
+			m_rPool(rPool)
+		{}
+
+		~closer() throw()
+		{
+			m_rPool.close();
+		}
+	};
+
+public:
+	///	The pool of the current module
+	static frame_pool& instance()
+	{
+		static frame_pool s_pool;
+		static closer s_closer(s_pool);
+		register_module_cache<&flush, &statistics>();
+		register_fork_handlers<&ignore_fork, &ignore_fork, &recover>();
+		return s_pool;
+	}
+
+	///	Add the frames cached by the current module's pool to @e rStats
+	static void statistics(module_cache_statistics& rStats)
+	{
+		frame_pool& rPool = instance();
+		for (size_t i = 0; i != pool_class_count; ++i)
+		{
+			const size_t nBytes = rPool.m_rings[i].size() * pool_size_classes::size(i);
+			rStats.m_nReservedBytes += nBytes;
+			rStats.m_nFreeBytes += nBytes;
+		}
+	}
+
+	// in the child, drop the ring slots of threads interrupted by fork
+	static void recover()
+	{
+		frame_pool& rPool = instance();
+		for (size_t i = 0; i != pool_class_count; ++i)
+			rPool.m_rings[i].recover();
+	}
+
+	///	Give the frames cached by the current module's pool back to the heap
+	static void flush()
+	{
+		frame_pool& rPool = instance();
+		for (size_t i = 0; i != pool_class_count; ++i)
+			while (void* p = rPool.m_rings[i].try_pop())
+				fetch_module_ops(false)->deallocate(p);
+	}
+
+	void* allocate(size_t nBytes)
+	{
+		if (nBytes > pool_max_block_size)
+			return fetch_module_ops(false)->allocate(nBytes);
+
+		const size_t nIndex = pool_size_classes::index(nBytes);
+		if (void* p = m_rings[nIndex].try_pop())
+			return p;
+		return fetch_module_ops(false)->allocate(pool_size_classes::size(nIndex));
+	}
+
+	void deallocate(void* p, size_t nBytes) throw()
+	{
+		if (nBytes > pool_max_block_size ||
+			m_bClosed.load(std::memory_order_acquire) ||
+			!m_rings[pool_size_classes::index(nBytes)].try_push(p))
+			fetch_module_ops(false)->deallocate(p);
+	}
+
+	///	Give all cached frames back to the heap, stop recycling
+	void close() throw()
+	{
+		m_bClosed.store(true, std::memory_order_release);
+		for (size_t i = 0; i != pool_class_count; ++i)
+			while (void* p = m_rings[i].try_pop())
+				fetch_module_ops(false)->deallocate(p);
+	}
+};
+
+
+// raw memory operations of the frame pool allocation mode
+template<size_t Depth>
+struct frame_pool_ops
+{
+	static void* allocate(size_t nBytes)
+	{
+		return frame_pool<Depth>::instance().allocate(nBytes);
+	}
+
+	static void* ops_allocate(const module_ops*, size_t nBytes)
+	{
+		return frame_pool<Depth>::instance().allocate(nBytes);
+	}
+
+	static void ops_deallocate(const module_ops*, void* p, size_t nBytes) throw()
+	{
+		frame_pool<Depth>::instance().deallocate(p, nBytes);
+	}
+
+	static const module_ops* fetch() throw()
+	{
+		// frames are plain heap blocks: deallocating without size bypasses 
+		// recycling; they are rounded to the size classes though, so the 
+		// table is a heap of its own, unequal to allocators of other modes
+		static const module_ops s_ops =
+		{
+			&allocate,
+			fetch_module_ops(false)->deallocate,
+			&s_ops,
+			&ops_allocate,
+			&ops_deallocate,
+			false,
+			fetch_module_ops(false)->hot,
+			fetch_module_ops(false)->cold
+		};
+
+		return &s_ops;
+	}
+};
+
+// precedes every coroutine frame, keeps the frame aligned like operator new does
+const size_t frame_header_size = (sizeof(const module_ops*) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+
+}	// namespace detail
+
+
+/**	@short	Frame pool allocation mode binds allocators to the frame pool of the current module
+ */
+template<size_t Depth, typename T>
+struct allocation_mode_traits<frame_pool_allocation<Depth>, T>
+{
+	static const module_ops* fetch_module_ops(bool) throw()
+	{
+		return detail::frame_pool_ops<Depth>::fetch();
+	}
+};
+
+
+/**	@short	Mixin for coroutine promise types allocating the coroutine frames
+	through the allocation mode @c RawAllocation of the module creating the
+	coroutine.
+
+	The frame is freed through the creating module's table no matter which
+	module destroys the coroutine.
+
+	@attention	The allocation throws @c std::bad_alloc on failure; promise
+	types declaring @c get_return_object_on_allocation_failure() need a
+	non-throwing @c operator @c new of their own.
+ */
+template<typename RawAllocation = frame_pool_allocation<> >
+struct modulebound_promise
+{
+	static void* operator new(size_t nBytes)
+	{
+		const module_ops* pOps = allocation_mode_traits<RawAllocation, void>::fetch_module_ops(RawAllocation::value == raw_allocation_array);
+		void* pBlock = pOps->ops_allocate(pOps, detail::frame_header_size + nBytes);
+		*static_cast<const module_ops**>(pBlock) = pOps;
+		return static_cast<char*>(pBlock) + detail::frame_header_size;
+	}
+
+	static void operator delete(void* p, size_t nBytes) throw()
+	{
+		void* pBlock = static_cast<char*>(p) - detail::frame_header_size;
+		const module_ops* pOps = *static_cast<const module_ops**>(pBlock);
+		pOps->ops_deallocate(pOps, pBlock, detail::frame_header_size + nBytes);
+	}
+};
+
+
+}	// namespace kj
+
+
+#endif	// file guard
@@ -0,0 +1,462 @@
+/**	@file	Epoch-based reclamation of nodes of lock-free structures shared
+	between modules.
+
+	Readers of a lock-free structure announce their critical sections to an
+	epoch domain; nodes unlinked by a writer are retired instead of freed and
+	are destroyed once every reader active at their unlinking has left its
+	critical section. A retired node is freed through the table of the
+	allocator it was allocated with, so it goes back to its owning module no
+	matter which thread or module reclaims it.
+
+	@code
+	// owned by the module owning the map
+	kj::epoch_domain domain;
+
+	// one participant per thread and domain, e.g. in the executor's thread state
+	kj::epoch_participant participant(domain);
+
+	// reader
+	{
+		kj::epoch_guard guard(participant);
+		const node* p = head.load(std::memory_order_acquire);
+		...
+	}
+
+	// writer, after unlinking p
+	participant.retire(p, nodeAllocator);
+	@endcode
+
+	@date	2026 10 17	kj	created
+ */
+
+#ifndef KJ_MODULEBOUND_EPOCH_H_INCLUDED
+#define KJ_MODULEBOUND_EPOCH_H_INCLUDED
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#  pragma once
+#endif
+
+#include <type_traits>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <stdexcept>	// std::length_error
+#include <cassert>
+#include <stdint.h>
+#include <stddef.h>
+#include "modulebound_allocator.h"
+#include "modulebound_lockfree.h"
+
+
+namespace kj
+{
+
+class epoch_participant;
+
+
+namespace detail
+{
+
+// participants a domain can hold at once
+const size_t max_epoch_participants = 256;
+// nodes retired per batch; a full batch triggers an attempt to reclaim
+const size_t retired_batch_capacity = 64;
+
+
+// a reader's announcement, 0 while outside a critical section,
+// the epoch shifted left by one and the lowest bit set inside
+struct alignas(cache_line_size) epoch_slot
+{
+	std::atomic<uint64_t> m_nState;
+	// guarded by the domain's mutex
+	bool m_bClaimed;
+};
+
+
+// function type destroying and freeing a retired node
+typedef void (*fp_reclaim_t)(void*, const module_ops*);
+
+template<typename T>
+void reclaim_node(void* p, const module_ops* pOps) throw()
+{
+	static_cast<T*>(p)->~T();
+	pOps->ops_deallocate(pOps, p, sizeof(T));
+}
+
+struct retired_node
+{
+	void* m_p;
+	// the table of the allocator that allocated the node
+	const module_ops* m_pOps;
+	fp_reclaim_t m_pfnReclaim;
+};
+
+
+/**	@short	Nodes retired by a participant, reclaimable together once the
+	domain's epoch is 2 ahead of the batch's epoch.
+ */
+struct retired_batch
+{
+	retired_batch* m_pNext;
+	// the table the batch itself was allocated with
+	const module_ops* m_pOps;
+	uint64_t m_nEpoch;
+	size_t m_nCount;
+	retired_node m_nodes[retired_batch_capacity];
+
+	///	@throw	@c std::bad_alloc
+	static retired_batch* create(const module_ops* pOps)
+	{
+		retired_batch* pBatch = ::new (pOps->allocate(sizeof(retired_batch))) retired_batch;
+		pBatch->m_pNext = 0;
+		pBatch->m_pOps = pOps;
+		pBatch->m_nEpoch = 0;
+		pBatch->m_nCount = 0;
+		return pBatch;
+	}
+
+	///	Reclaim the nodes and free the batch
+	void destroy() throw()
+	{
+		for (size_t i = 0; i != m_nCount; ++i)
+			m_nodes[i].m_pfnReclaim(m_nodes[i].m_p, m_nodes[i].m_pOps);
+		m_pOps->deallocate(this);
+	}
+
+	static void destroy_list(retired_batch* p) throw()
+	{
+		while (p)
+		{
+			retired_batch* pNext = p->m_pNext;
+			p->destroy();
+			p = pNext;
+		}
+	}
+};
+
+}	// namespace detail
+
+
+/**	@short	Epoch of a lock-free structure (or of several), which its
+	readers announce their critical sections to.
+
+	The domain is shared by reference between the modules accessing the
+	structure and must outlive all its participants; destroying it reclaims
+	the nodes still retired.
+
+	@attention	Retired nodes are destroyed by code of the module that
+	retired them and freed by the module that allocated them; both modules
+	must stay loaded until the nodes are reclaimed.
+ */
+class epoch_domain
+{
+	friend class epoch_participant;
+
+	alignas(detail::cache_line_size) std::atomic<uint64_t> m_nEpoch;
+	// number of slots ever claimed, the slots to scan
+	std::atomic<size_t> m_nSlotCount;
+	// batches of participants gone, guarded by m_mutex
+	std::atomic<detail::retired_batch*> m_pOrphans;
+	std::mutex m_mutex;
+	detail::epoch_slot m_slots[detail::max_epoch_participants];
+
+	// noncopyable
+	epoch_domain(const epoch_domain&);
+	epoch_domain& operator =(const epoch_domain&);
+
+	detail::epoch_slot& claim_slot()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (size_t i = 0; i != detail::max_epoch_participants; ++i)
+		{
+			if (m_slots[i].m_bClaimed)
+				continue;
+			m_slots[i].m_bClaimed = true;
+			if (i >= m_nSlotCount.load(std::memory_order_relaxed))
+				m_nSlotCount.store(i + 1, std::memory_order_release);
+			return m_slots[i];
+		}
+		throw std::length_error("kj::epoch_participant");
+	}
+
+	void release_slot(detail::epoch_slot& rSlot, detail::retired_batch* pBatches) throw()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		rSlot.m_nState.store(0, std::memory_order_release);
+		rSlot.m_bClaimed = false;
+		if (!pBatches)
+			return;
+
+		detail::retired_batch* pLast = pBatches;
+		while (pLast->m_pNext)
+			pLast = pLast->m_pNext;
+		pLast->m_pNext = m_pOrphans.load(std::memory_order_relaxed);
+		m_pOrphans.store(pBatches, std::memory_order_relaxed);
+	}
+
+	// reclaim the orphaned batches old enough, unless another thread is at it
+	void collect_orphans(uint64_t nEpoch) throw()
+	{
+		if (!m_pOrphans.load(std::memory_order_relaxed))
+			return;
+		std::unique_lock<std::mutex> lock(m_mutex, std::try_to_lock);
+		if (!lock.owns_lock())
+			return;
+
+		detail::retired_batch* pReclaimable = 0;
+		detail::retired_batch* pKept = 0;
+		for (detail::retired_batch* p = m_pOrphans.load(std::memory_order_relaxed); p;)
+		{
+			detail::retired_batch* pNext = p->m_pNext;
+			detail::retired_batch*& rpList = p->m_nEpoch + 2 <= nEpoch ? pReclaimable : pKept;
+			p->m_pNext = rpList;
+			rpList = p;
+			p = pNext;
+		}
+		m_pOrphans.store(pKept, std::memory_order_relaxed);
+		lock.unlock();
+
+		detail::retired_batch::destroy_list(pReclaimable);
+	}
+
+public:
+	epoch_domain() throw():
+		m_nEpoch(0),
+		m_nSlotCount(0),
+		m_pOrphans(0)
+	{
+		for (size_t i = 0; i != detail::max_epoch_participants; ++i)
+		{
+			m_slots[i].m_nState.store(0, std::memory_order_relaxed);
+			m_slots[i].m_bClaimed = false;
+		}
+	}
+
+	~epoch_domain() throw()
+	{
+		assert(!any_participant());
+		detail::retired_batch::destroy_list(m_pOrphans.load(std::memory_order_relaxed));
+	}
+
+	///	The current epoch
+	uint64_t epoch() const throw()
+	{
+		return m_nEpoch.load(std::memory_order_acquire);
+	}
+
+	/**	@short	Advance the epoch if every reader inside a critical section
+		has announced the current one.
+		@return	The epoch afterwards
+	 */
+	uint64_t try_advance() throw()
+	{
+		uint64_t nEpoch = m_nEpoch.load(std::memory_order_seq_cst);
+		const size_t nSlots = m_nSlotCount.load(std::memory_order_acquire);
+		for (size_t i = 0; i != nSlots; ++i)
+		{
+			const uint64_t nState = m_slots[i].m_nState.load(std::memory_order_seq_cst);
+			if ((nState & 1) && (nState >> 1) != nEpoch)
+				return nEpoch;
+		}
+
+		// if another thread advanced it, nEpoch receives the new epoch
+		if (m_nEpoch.compare_exchange_strong(nEpoch, nEpoch + 1, std::memory_order_seq_cst))
+			++nEpoch;
+		return nEpoch;
+	}
+
+	/**	@short	Reclaim what participants that are gone left behind, as far
+		as the readers allow
+	 */
+	void collect() throw()
+	{
+		collect_orphans(try_advance());
+	}
+
+	///	Whether a participant is registered, for diagnostics
+	bool any_participant() throw()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (size_t i = 0; i != detail::max_epoch_participants; ++i)
+			if (m_slots[i].m_bClaimed)
+				return true;
+		return false;
+	}
+};
+
+
+/**	@short	A thread's membership in an epoch domain.
+
+	Used by one thread at a time; a thread accessing several domains needs a
+	participant for each. Nodes retired through the participant are collected
+	in batches; whenever a batch fills up the participant tries to advance the
+	epoch and reclaims its batches the readers are done with.
+	On destruction the participant's remaining batches are handed to the
+	domain, which reclaims them on a later @c collect() or on destruction.
+
+	@throw	@c std::length_error on construction if the domain has
+		@c detail::max_epoch_participants participants already
+ */
+class epoch_participant
+{
+	epoch_domain& m_rDomain;
+	detail::epoch_slot& m_rSlot;
+	// the table of the module constructing the participant, for its batches
+	const module_ops* m_pOps;
+	unsigned m_nNesting;
+	// being filled
+	detail::retired_batch* m_pOpen;
+	// full, oldest first
+	detail::retired_batch* m_pSealed;
+	detail::retired_batch* m_pSealedLast;
+
+	// noncopyable
+	epoch_participant(const epoch_participant&);
+	epoch_participant& operator =(const epoch_participant&);
+
+	void seal() throw()
+	{
+		// nodes retired so far are unlinked already, readers entering from
+		// now on can't reach them
+		m_pOpen->m_nEpoch = m_rDomain.epoch();
+		if (m_pSealedLast)
+			m_pSealedLast->m_pNext = m_pOpen;
+		else
+			m_pSealed = m_pOpen;
+		m_pSealedLast = m_pOpen;
+		m_pOpen = 0;
+	}
+
+	void retire_node(void* p, const module_ops* pOps, detail::fp_reclaim_t pfnReclaim)
+	{
+		if (!m_pOpen)
+			m_pOpen = detail::retired_batch::create(m_pOps);
+
+		detail::retired_node& rNode = m_pOpen->m_nodes[m_pOpen->m_nCount++];
+		rNode.m_p = p;
+		rNode.m_pOps = pOps;
+		rNode.m_pfnReclaim = pfnReclaim;
+
+		if (m_pOpen->m_nCount == detail::retired_batch_capacity)
+		{
+			seal();
+			collect();
+		}
+	}
+
+public:
+	///	@throw	@c std::length_error, @c std::system_error
+	explicit epoch_participant(epoch_domain& rDomain):
+		m_rDomain(rDomain),
+		m_rSlot(rDomain.claim_slot()),
+		m_pOps(detail::fetch_module_ops(false)),
+		m_nNesting(0),
+		m_pOpen(0),
+		m_pSealed(0),
+		m_pSealedLast(0)
+	{}
+
+	~epoch_participant() throw()
+	{
+		assert(!m_nNesting);
+		if (m_pOpen)
+			seal();
+		m_rDomain.release_slot(m_rSlot, m_pSealed);
+	}
+
+	/**	@short	Begin a critical section; nodes reachable from now on stay
+		valid until the matching leave(). Critical sections nest.
+	 */
+	void enter() throw()
+	{
+		if (m_nNesting++)
+			return;
+		m_rSlot.m_nState.store((m_rDomain.m_nEpoch.load(std::memory_order_relaxed) << 1) | 1, std::memory_order_seq_cst);
+		// the announcement must be visible before the structure is read
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+	}
+
+	///	End a critical section
+	void leave() throw()
+	{
+		assert(m_nNesting);
+		if (!--m_nNesting)
+			m_rSlot.m_nState.store(0, std::memory_order_release);
+	}
+
+	/**	@short	Destroy and free the node at @e p, allocated by @e rAllocator,
+		once no reader can reach it anymore.
+
+		The node must be unlinked from the structure already. It is freed
+		through @e rAllocator's table, i.e. in the module that allocated it.
+		@throw	@c std::bad_alloc if a new batch can't be allocated, @e p is
+			not retired then
+	 */
+	template<typename T, typename RawAllocation>
+	void retire(T* p, const modulebound_allocator<T, RawAllocation>& rAllocator)
+	{
+		retire_node(const_cast<typename std::remove_const<T>::type*>(p), rAllocator.get_module_ops(), &detail::reclaim_node<typename std::remove_const<T>::type>);
+	}
+
+	/**	@short	Try to advance the epoch and reclaim the batches the readers
+		are done with
+	 */
+	void collect() throw()
+	{
+		const uint64_t nEpoch = m_rDomain.try_advance();
+		while (m_pSealed && m_pSealed->m_nEpoch + 2 <= nEpoch)
+		{
+			detail::retired_batch* pBatch = m_pSealed;
+			m_pSealed = pBatch->m_pNext;
+			if (!m_pSealed)
+				m_pSealedLast = 0;
+			pBatch->destroy();
+		}
+		m_rDomain.collect_orphans(nEpoch);
+	}
+
+	/**	@short	Reclaim all nodes retired so far, including those of a batch
+		not yet full; called outside a critical section, succeeds if the
+		other participants leave theirs meanwhile.
+		@return	Whether nothing retired through this participant is left
+	 */
+	bool flush() throw()
+	{
+		if (m_pOpen)
+			seal();
+		// two epochs must pass
+		for (int i = 0; i != 3 && m_pSealed; ++i)
+			collect();
+		return !m_pSealed;
+	}
+};
+
+
+/**	@short	Critical section of a participant for the lifetime of the guard
+ */
+class epoch_guard
+{
+	epoch_participant& m_rParticipant;
+
+	// noncopyable
+	epoch_guard(const epoch_guard&);
+	epoch_guard& operator =(const epoch_guard&);
+
+public:
+	explicit epoch_guard(epoch_participant& rParticipant) throw():
+		m_rParticipant(rParticipant)
+	{
+		m_rParticipant.enter();
+	}
+
+	~epoch_guard() throw()
+	{
+		m_rParticipant.leave();
+	}
+};
+
+
+}	// namespace kj
+
+
+#endif	// file guard
@@ -0,0 +1,489 @@
+/**	@file	String interning pool shared between modules.
+
+	Plugins sending the same symbols and tags over and over can intern them
+	once in a pool owned by the host: every distinct string is stored once,
+	in storage of the owning module that never moves, and is referred to by
+	a handle. Handles of the same pool are equal exactly if their strings are
+	equal, so string equality becomes a pointer comparison.
+
+	@code
+	// host
+	kj::string_intern_pool symbols;
+	plugin->init(symbols);
+
+	// plugin, any thread
+	kj::interned_string tag = symbols.intern("content-type");
+	if (tag == s_contentType)
+		...
+	@endcode
+
+	Hashing and comparing run in the owning module (the pool is reached
+	through a virtual interface), so all modules agree on the hash even if
+	they are built with different instruction sets. The owning module uses
+	CRC32-C instructions for hashing if it is built with SSE 4.2 and SSE2 for
+	comparing if available, portable word-wise code otherwise.
+
+	@date	2026 10 17	kj	created
+ */
+
+#ifndef KJ_MODULEBOUND_INTERN_H_INCLUDED
+#define KJ_MODULEBOUND_INTERN_H_INCLUDED
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#  pragma once
+#endif
+
+#include <type_traits>
+#include <atomic>
+#include <mutex>
+#include <string>	// std::basic_string
+#include <functional>	// std::less
+#include <new>
+#include <cstring>	// std::memcpy, std::memcmp, std::strlen
+#include <stdint.h>
+#include <stddef.h>
+#include "modulebound_allocator.h"
+#include "modulebound_memory.h"
+
+#if defined(__SSE4_2__) && (defined(__x86_64__) || defined(_M_X64))
+#  include <nmmintrin.h>
+#  define KJ_MODULEBOUND_INTERN_CRC32
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define KJ_MODULEBOUND_INTERN_SSE2
+#endif
+
+
+namespace kj
+{
+
+namespace detail
+{
+
+/**	@short	An interned string, with a fixed layout: hash, size and the
+	null-terminated characters.
+ */
+struct interned_entry
+{
+	uint64_t m_nHash;
+	size_t m_nSize;
+	// the characters follow, m_nSize + 1 of them
+	char m_sz[1];
+};
+
+
+// load 8 bytes from an arbitrary address
+inline
+uint64_t load_word(const char* p) throw()
+{
+	uint64_t n;
+	std::memcpy(&n, p, sizeof(n));
+	return n;
+}
+
+// spread the bits of n over the whole word (murmur3's finalizer)
+inline
+uint64_t mix_hash(uint64_t n) throw()
+{
+	n ^= n >> 33;
+	n *= 0xff51afd7ed558ccdull;
+	n ^= n >> 33;
+	n *= 0xc4ceb9fe1a85ec53ull;
+	n ^= n >> 33;
+	return n;
+}
+
+inline
+uint64_t hash_string(const char* p, size_t nSize) throw()
+{
+	const char* const pEnd = p + nSize;
+#ifdef KJ_MODULEBOUND_INTERN_CRC32
+	uint64_t nCrc = nSize;
+	for (; pEnd - p >= 8; p += 8)
+		nCrc = _mm_crc32_u64(nCrc, load_word(p));
+	for (; p != pEnd; ++p)
+		nCrc = _mm_crc32_u8(uint32_t(nCrc), uint8_t(*p));
+	// crc32 yields 32 bits, the length keeps the upper half apart
+	return mix_hash(nCrc ^ (uint64_t(nSize) << 32));
+#else
+	uint64_t nHash = nSize * 0x9e3779b97f4a7c15ull;
+	for (; pEnd - p >= 8; p += 8)
+		nHash = (nHash ^ mix_hash(load_word(p))) * 0x9e3779b97f4a7c15ull;
+	uint64_t nTail = 0;
+	for (unsigned nShift = 0; p != pEnd; ++p, nShift += 8)
+		nTail |= uint64_t(uint8_t(*p)) << nShift;
+	return mix_hash(nHash ^ nTail);
+#endif
+}
+
+inline
+bool equal_chars(const char* p, const char* q, size_t nSize) throw()
+{
+#ifdef KJ_MODULEBOUND_INTERN_SSE2
+	for (; nSize >= 16; p += 16, q += 16, nSize -= 16)
+	{
+		const __m128i left = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+		const __m128i right = _mm_loadu_si128(reinterpret_cast<const __m128i*>(q));
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(left, right)) != 0xffff)
+			return false;
+	}
+#endif
+	for (; nSize >= 8; p += 8, q += 8, nSize -= 8)
+		if (load_word(p) != load_word(q))
+			return false;
+	return !nSize || !std::memcmp(p, q, nSize);
+}
+
+
+/**	@short	Interface modules reach the pool through, so the pool's own
+	code hashes, compares and allocates.
+ */
+class intern_pool_core
+{
+public:
+	virtual ~intern_pool_core() throw()
+	{}
+
+	virtual const interned_entry* intern(const char* p, size_t nSize) = 0;
+	virtual const interned_entry* find(const char* p, size_t nSize) const throw() = 0;
+	virtual size_t size() const throw() = 0;
+};
+
+
+/**	@short	Open-addressing hash table of interned strings, lock-free for
+	lookups; inserting takes a mutex.
+
+	Grown tables replace the table readers see, the previous ones are kept
+	until the pool is destroyed, as readers may still search them.
+	Strings are stored in chunks, which are never moved or freed before the
+	pool is destroyed.
+ */
+class intern_pool_state: public intern_pool_core
+{
+	struct table
+	{
+		table* m_pPrevious;
+		size_t m_nMask;
+		std::atomic<const interned_entry*> m_slots[1];
+	};
+
+	struct chunk
+	{
+		chunk* m_pPrevious;
+	};
+
+	static const size_t chunk_size = 64 * 1024;
+	static const size_t initial_capacity = 1024;
+
+	// captured in the module constructing the pool
+	const module_ops* const m_pOps;
+	std::atomic<table*> m_pTable;
+	// guards inserting and the members below
+	mutable std::mutex m_mutex;
+	size_t m_nCount;
+	chunk* m_pChunk;
+	char* m_pFree;
+	char* m_pEnd;
+
+	// noncopyable
+	intern_pool_state(const intern_pool_state&);
+	intern_pool_state& operator =(const intern_pool_state&);
+
+	table* create_table(size_t nCapacity, table* pPrevious)
+	{
+		table* pTable = static_cast<table*>(m_pOps->allocate(offsetof(table, m_slots) + nCapacity * sizeof(pTable->m_slots[0])));
+		pTable->m_pPrevious = pPrevious;
+		pTable->m_nMask = nCapacity - 1;
+		for (size_t i = 0; i != nCapacity; ++i)
+			::new (static_cast<void*>(&pTable->m_slots[i])) std::atomic<const interned_entry*>(0);
+		return pTable;
+	}
+
+	static const interned_entry* search(const table* pTable, uint64_t nHash, const char* p, size_t nSize) throw()
+	{
+		for (size_t i = size_t(nHash) & pTable->m_nMask;; i = (i + 1) & pTable->m_nMask)
+		{
+			const interned_entry* pEntry = pTable->m_slots[i].load(std::memory_order_acquire);
+			if (!pEntry)
+				return 0;
+			if (pEntry->m_nHash == nHash && pEntry->m_nSize == nSize && equal_chars(pEntry->m_sz, p, nSize))
+				return pEntry;
+		}
+	}
+
+	static void insert(table* pTable, const interned_entry* pEntry) throw()
+	{
+		size_t i = size_t(pEntry->m_nHash) & pTable->m_nMask;
+		while (pTable->m_slots[i].load(std::memory_order_relaxed))
+			i = (i + 1) & pTable->m_nMask;
+		pTable->m_slots[i].store(pEntry, std::memory_order_release);
+	}
+
+	// storage for an entry of nSize characters
+	void* allocate_entry(size_t nSize)
+	{
+		const size_t nBytes = (offsetof(interned_entry, m_sz) + nSize + 1 + alignof(interned_entry) - 1) & ~(alignof(interned_entry) - 1);
+		if (size_t(m_pEnd - m_pFree) < nBytes)
+		{
+			// large strings get a chunk of their own
+			const size_t nChunkBytes = sizeof(chunk) + (nBytes > chunk_size / 4 ? nBytes : chunk_size);
+			chunk* pChunk = static_cast<chunk*>(m_pOps->allocate(nChunkBytes));
+			pChunk->m_pPrevious = m_pChunk;
+			m_pChunk = pChunk;
+			m_pFree = reinterpret_cast<char*>(pChunk + 1);
+			m_pEnd = reinterpret_cast<char*>(pChunk) + nChunkBytes;
+		}
+
+		void* p = m_pFree;
+		m_pFree += nBytes;
+		return p;
+	}
+
+public:
+	///	@throw	@c std::bad_alloc
+	intern_pool_state():
+		m_pOps(fetch_module_ops(true)),
+		m_pTable(0),
+		m_nCount(0),
+		m_pChunk(0),
+		m_pFree(0),
+		m_pEnd(0)
+	{
+		static_assert(alignof(chunk) >= alignof(interned_entry), "entries are placed right after a chunk's header");
+		m_pTable.store(create_table(initial_capacity, 0), std::memory_order_release);
+	}
+
+	virtual ~intern_pool_state() throw()
+	{
+		for (table* pTable = m_pTable.load(std::memory_order_relaxed); pTable;)
+		{
+			table* pPrevious = pTable->m_pPrevious;
+			m_pOps->deallocate(pTable);
+			pTable = pPrevious;
+		}
+		while (m_pChunk)
+		{
+			chunk* pPrevious = m_pChunk->m_pPrevious;
+			m_pOps->deallocate(m_pChunk);
+			m_pChunk = pPrevious;
+		}
+	}
+
+	virtual const interned_entry* intern(const char* p, size_t nSize)
+	{
+		const uint64_t nHash = hash_string(p, nSize);
+		if (const interned_entry* pEntry = search(m_pTable.load(std::memory_order_acquire), nHash, p, nSize))
+			return pEntry;
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		table* pTable = m_pTable.load(std::memory_order_relaxed);
+		// another thread may have interned it meanwhile
+		if (const interned_entry* pEntry = search(pTable, nHash, p, nSize))
+			return pEntry;
+
+		// keep the table at most half full
+		if ((m_nCount + 1) * 2 > pTable->m_nMask + 1)
+		{
+			table* pGrown = create_table((pTable->m_nMask + 1) * 2, pTable);
+			for (size_t i = 0; i <= pTable->m_nMask; ++i)
+				if (const interned_entry* pEntry = pTable->m_slots[i].load(std::memory_order_relaxed))
+					insert(pGrown, pEntry);
+			m_pTable.store(pGrown, std::memory_order_release);
+			pTable = pGrown;
+		}
+
+		interned_entry* pEntry = static_cast<interned_entry*>(allocate_entry(nSize));
+		pEntry->m_nHash = nHash;
+		pEntry->m_nSize = nSize;
+		if (nSize)
+			std::memcpy(pEntry->m_sz, p, nSize);
+		pEntry->m_sz[nSize] = '\0';
+		insert(pTable, pEntry);
+		++m_nCount;
+		return pEntry;
+	}
+
+	virtual const interned_entry* find(const char* p, size_t nSize) const throw()
+	{
+		const uint64_t nHash = hash_string(p, nSize);
+		for (;;)
+		{
+			const table* pTable = m_pTable.load(std::memory_order_acquire);
+			if (const interned_entry* pEntry = search(pTable, nHash, p, nSize))
+				return pEntry;
+			// not there unless the table grew meanwhile
+			if (m_pTable.load(std::memory_order_acquire) == pTable)
+				return 0;
+		}
+	}
+
+	virtual size_t size() const throw()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_nCount;
+	}
+};
+
+}	// namespace detail
+
+
+/**	@short	Handle of a string interned by a @c string_intern_pool.
+
+	Valid as long as the pool exists. Handles of the same pool compare equal
+	exactly if their strings are equal; handles of different pools must not
+	be compared. A default constructed handle refers to no string.
+ */
+class interned_string
+{
+	const detail::interned_entry* m_pEntry;
+
+public:
+	interned_string() throw():
+		m_pEntry(0)
+	{}
+
+	explicit interned_string(const detail::interned_entry* pEntry) throw():
+		m_pEntry(pEntry)
+	{}
+
+	///	Whether the handle refers to a string
+	bool valid() const throw()
+	{
+		return m_pEntry != 0;
+	}
+
+	///	The null-terminated characters, "" for a handle referring to no string
+	const char* c_str() const throw()
+	{
+		return m_pEntry ? m_pEntry->m_sz : "";
+	}
+
+	const char* data() const throw()
+	{
+		return c_str();
+	}
+
+	size_t size() const throw()
+	{
+		return m_pEntry ? m_pEntry->m_nSize : 0;
+	}
+
+	bool empty() const throw()
+	{
+		return !size();
+	}
+
+	///	The string's hash, e.g. for hash tables keyed by handles
+	size_t hash() const throw()
+	{
+		return m_pEntry ? size_t(m_pEntry->m_nHash) : 0;
+	}
+
+	friend bool operator ==(interned_string left, interned_string right) throw()
+	{
+		return left.m_pEntry == right.m_pEntry;
+	}
+
+	friend bool operator !=(interned_string left, interned_string right) throw()
+	{
+		return left.m_pEntry != right.m_pEntry;
+	}
+
+	///	An arbitrary but fixed order, e.g. for ordered containers keyed by handles
+	friend bool operator <(interned_string left, interned_string right) throw()
+	{
+		return std::less<const detail::interned_entry*>()(left.m_pEntry, right.m_pEntry);
+	}
+};
+
+
+/**	@short	Concurrent string interning table owned by the module that
+	constructs it.
+
+	Interning and looking up strings is safe from any thread and module;
+	lookups of strings interned already don't lock. The strings' storage is
+	allocated by the constructing module and freed when the pool is
+	destroyed, which invalidates all handles.
+ */
+class string_intern_pool
+{
+	module_unique_ptr<detail::intern_pool_core> m_pCore;
+
+	// noncopyable
+	string_intern_pool(const string_intern_pool&);
+	string_intern_pool& operator =(const string_intern_pool&);
+
+	// allocated by the current module's raw operators like the core's 
+	// tables and chunks, so a region active meanwhile doesn't own it
+	static module_unique_ptr<detail::intern_pool_core> create_core()
+	{
+		const module_ops* pOps = detail::fetch_module_ops(false);
+		void* p = pOps->allocate(sizeof(detail::intern_pool_state));
+		try
+		{
+			return module_unique_ptr<detail::intern_pool_core>(
+				::new (p) detail::intern_pool_state(), 
+				module_deleter<detail::intern_pool_core>(pOps->deallocate)
+			);
+		}
+		catch (...)
+		{
+			pOps->deallocate(p);
+			throw;
+		}
+	}
+
+public:
+	///	@throw	@c std::bad_alloc
+	string_intern_pool():
+		m_pCore(create_core())
+	{}
+
+	/**	@short	The handle of the string [@e p, @e p + @e nSize), interning it
+		if it isn't yet
+		@throw	@c std::bad_alloc
+	 */
+	interned_string intern(const char* p, size_t nSize)
+	{
+		return interned_string(m_pCore->intern(p, nSize));
+	}
+
+	///	@throw	@c std::bad_alloc
+	interned_string intern(const char* psz)
+	{
+		return intern(psz, std::strlen(psz));
+	}
+
+	///	@throw	@c std::bad_alloc
+	template<typename Traits, typename Allocator>
+	interned_string intern(const std::basic_string<char, Traits, Allocator>& rString)
+	{
+		return intern(rString.data(), rString.size());
+	}
+
+	/**	@short	The handle of the string [@e p, @e p + @e nSize) if it is
+		interned, otherwise a handle referring to no string
+	 */
+	interned_string find(const char* p, size_t nSize) const throw()
+	{
+		return interned_string(m_pCore->find(p, nSize));
+	}
+
+	interned_string find(const char* psz) const throw()
+	{
+		return find(psz, std::strlen(psz));
+	}
+
+	///	Number of distinct strings interned
+	size_t size() const throw()
+	{
+		return m_pCore->size();
+	}
+};
+
+
+}	// namespace kj
+
+
+#endif	// file guard
@@ -0,0 +1,276 @@
+/**	@file	Lifecycle hooks for the caches of the module-bound allocation modes.
+
+	Pools and recycling rings of a module keep freed blocks for reuse. They
+	register with the module's cache registry, which drains them all on
+	request (e.g. before the module gets unloaded) and when the module exits.
+
+	On POSIX systems the registry also installs fork handlers for the module
+	(@c pthread_atfork): the locks of the pools, heaps and registries are
+	acquired before @c fork and released afterwards in both processes, and
+	state referring to the threads that don't exist in the child is reset.
+	Blocks the other threads were holding are never freed in the child, and
+	an unsynchronized pool is only consistent in the child if its thread
+	forked or wasn't using it at the time.
+
+	@code
+	// plugin, before being unloaded
+	extern "C" void plugin_shutdown()
+	{
+		stop_workers();
+		kj::flush_module_caches();
+	}
+	@endcode
+
+	@date	2026 10 17	kj	created
+ */
+
+#ifndef KJ_MODULEBOUND_LIFECYCLE_H_INCLUDED
+#define KJ_MODULEBOUND_LIFECYCLE_H_INCLUDED
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#  pragma once
+#endif
+
+#include <type_traits>
+#include <mutex>
+#include <new>
+#include <stddef.h>
+#if !defined(_WIN32)
+#  include <pthread.h>
+#  define KJ_MODULEBOUND_FORK_HANDLERS
+#endif
+
+
+namespace kj
+{
+
+/**	@short	Memory held by the caches of a module's allocation modes
+ */
+struct module_cache_statistics
+{
+	///	number of caches of the module in use
+	size_t m_nCaches;
+	///	bytes the caches got from the heap
+	size_t m_nReservedBytes;
+	///	bytes of the blocks in use, rounded up to the caches' block sizes
+	size_t m_nUsedBytes;
+	///	bytes of the freed blocks kept for reuse
+	size_t m_nFreeBytes;
+};
+
+
+namespace detail
+{
+
+/**	@short	Entry of a cache in the module's cache registry
+ */
+struct module_cache_hook
+{
+	///	gives the cached blocks back to the heap
+	void (*m_pfnFlush)();
+	///	adds the cache's memory to the statistics
+	void (*m_pfnStatistics)(module_cache_statistics&);
+	module_cache_hook* m_pNext;
+};
+
+/**	@short	Entry of a fork handler in the module's cache registry
+ */
+struct module_fork_hook
+{
+	///	acquires the locks before fork
+	void (*m_pfnPrepare)();
+	///	releases them in the parent
+	void (*m_pfnParent)();
+	///	releases them and resets the state of vanished threads in the child
+	void (*m_pfnChild)();
+	module_fork_hook* m_pNext;
+};
+
+
+/**	@short	Per-module registry of the caches of the allocation modes.
+
+	The registry is never destroyed, so caches registering during static
+	destruction find it intact; it drains the caches when the module exits.
+	Its lock guards the hook lists; around fork it is taken before the locks
+	of the caches.
+ */
+class module_cache_registry
+{
+	std::mutex m_mutex;
+	module_cache_hook* m_pHooks;
+	module_fork_hook* m_pForkHooks;
+
+	module_cache_registry() throw():
+		m_pHooks(0),
+		m_pForkHooks(0)
+	{}
+
+	struct closer
+	{
+		module_cache_registry& m_rRegistry;
+
+		explicit closer(module_cache_registry& rRegistry) throw():
+			m_rRegistry(rRegistry)
+		{}
+
+		~closer() throw()
+		{
+			m_rRegistry.flush_all();
+		}
+	};
+
+public:
+	///	The registry of the current module
+	static module_cache_registry& instance()
+	{
+		static std::aligned_storage<sizeof(module_cache_registry), alignof(module_cache_registry)>::type s_storage;
+		static module_cache_registry* s_pRegistry = ::new (static_cast<void*>(&s_storage)) module_cache_registry();
+		static closer s_closer(*s_pRegistry);
+#ifdef KJ_MODULEBOUND_FORK_HANDLERS
+		// the c runtime removes the handlers when the module is unloaded
+		static const int s_nForkHandlers = ::pthread_atfork(&fork_prepare, &fork_parent, &fork_child);
+		(void) s_nForkHandlers;
+#endif
+		return *s_pRegistry;
+	}
+
+	void add(module_cache_hook* pHook) throw()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		pHook->m_pNext = m_pHooks;
+		m_pHooks = pHook;
+	}
+
+	void add(module_fork_hook* pHook) throw()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		pHook->m_pNext = m_pForkHooks;
+		m_pForkHooks = pHook;
+	}
+
+	/**	@short	The hooks registered so far.
+
+		Hooks are only ever prepended and never removed, so the list from the
+		returned head stays valid and unchanged; the hooks are called without
+		holding the lock, they may register further hooks.
+	 */
+	module_cache_hook* hooks() throw()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_pHooks;
+	}
+
+	void flush_all() throw()
+	{
+		for (module_cache_hook* pHook = hooks(); pHook; pHook = pHook->m_pNext)
+			pHook->m_pfnFlush();
+	}
+
+	module_cache_statistics statistics() throw()
+	{
+		module_cache_statistics stats = {};
+		for (module_cache_hook* pHook = hooks(); pHook; pHook = pHook->m_pNext)
+		{
+			++stats.m_nCaches;
+			pHook->m_pfnStatistics(stats);
+		}
+		return stats;
+	}
+
+	// fork handlers: the registry's lock is held from prepare until parent/child
+	static void fork_prepare()
+	{
+		module_cache_registry& rRegistry = instance();
+		rRegistry.m_mutex.lock();
+		for (module_fork_hook* pHook = rRegistry.m_pForkHooks; pHook; pHook = pHook->m_pNext)
+			pHook->m_pfnPrepare();
+	}
+
+	static void fork_parent()
+	{
+		module_cache_registry& rRegistry = instance();
+		for (module_fork_hook* pHook = rRegistry.m_pForkHooks; pHook; pHook = pHook->m_pNext)
+			pHook->m_pfnParent();
+		rRegistry.m_mutex.unlock();
+	}
+
+	static void fork_child()
+	{
+		module_cache_registry& rRegistry = instance();
+		for (module_fork_hook* pHook = rRegistry.m_pForkHooks; pHook; pHook = pHook->m_pNext)
+			pHook->m_pfnChild();
+		rRegistry.m_mutex.unlock();
+	}
+};
+
+
+/**	@short	Register the cache flushed by @c pfnFlush and described by
+	@c pfnStatistics with the current module's registry, once
+ */
+template<void (*pfnFlush)(), void (*pfnStatistics)(module_cache_statistics&)> inline
+void register_module_cache()
+{
+	static module_cache_hook s_hook = { pfnFlush, pfnStatistics, 0 };
+	static const bool s_bRegistered = (module_cache_registry::instance().add(&s_hook), true);
+	(void) s_bRegistered;
+}
+
+// fork handler of caches with nothing to do at that point
+inline
+void ignore_fork()
+{}
+
+/**	@short	Register fork handlers with the current module's registry, once.
+
+	@c pfnPrepare mustn't take a lock that is held while the registry's lock
+	is taken.
+ */
+template<void (*pfnPrepare)(), void (*pfnParent)(), void (*pfnChild)()> inline
+void register_fork_handlers()
+{
+	static module_fork_hook s_hook = { pfnPrepare, pfnParent, pfnChild, 0 };
+	static const bool s_bRegistered = (module_cache_registry::instance().add(&s_hook), true);
+	(void) s_bRegistered;
+}
+
+}	// namespace detail
+
+
+/**	@short	Give the blocks cached by the allocation modes of the current
+	module back to the heap.
+
+	Recycling rings are emptied; pools give their chunks back if none of
+	their blocks is in use. The caches are drained at module exit anyway,
+	calling this function lets a module do it at a defined point, e.g. before
+	it gets unloaded, or to trim memory after a load peak.
+
+	Pools of the unsynchronized allocation mode are confined to their thread
+	and not flushed here, see @c trim_unsynchronized_pool().
+	@note	The allocation modes cache per module, not per thread, so exiting
+	threads leave no cached blocks behind.
+ */
+inline
+void flush_module_caches()
+{
+	detail::module_cache_registry::instance().flush_all();
+}
+
+/**	@short	Memory held by the caches of the allocation modes of the current
+	module.
+
+	The free bytes of the pools and slab heaps are their external
+	fragmentation: memory taken from the heap that no block in use occupies.
+	Pools of the unsynchronized allocation mode aren't counted, see
+	@c get_unsynchronized_pool_statistics().
+ */
+inline
+module_cache_statistics get_module_cache_statistics()
+{
+	return detail::module_cache_registry::instance().statistics();
+}
+
+
+}	// namespace kj
+
+
+#endif	// file guard
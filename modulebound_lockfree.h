@@ -0,0 +1,160 @@
+/**	@file	Lock-free building blocks shared by the module-bound allocation modes.
+
+	@date	2026 10 17	kj	created
+ */
+
+#ifndef KJ_MODULEBOUND_LOCKFREE_H_INCLUDED
+#define KJ_MODULEBOUND_LOCKFREE_H_INCLUDED
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#  pragma once
+#endif
+
+#include <atomic>
+#include <stddef.h>
+
+
+namespace kj
+{
+
+namespace detail
+{
+
+// assumed size of a cache line, separates data written by different threads
+const size_t cache_line_size = 64;
+
+
+/**	@short	Bounded lock-free multi-producer/multi-consumer ring of pointers
+	(after Dmitry Vyukov's bounded MPMC queue).
+
+	Each cell carries a sequence number telling producers and consumers
+	whether it is free or occupied in the current lap, which makes the ring
+	immune to the ABA problem without double-word compare-and-swap.
+	Pushing fails if the ring is full, popping fails if it is empty.
+ */
+template<size_t Capacity>
+class bounded_pointer_ring
+{
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+	struct cell
+	{
+		std::atomic<size_t> m_nSequence;
+		void* m_p;
+	};
+
+	alignas(cache_line_size) std::atomic<size_t> m_nEnqueuePos;
+	alignas(cache_line_size) std::atomic<size_t> m_nDequeuePos;
+	alignas(cache_line_size) cell m_cells[Capacity];
+
+	// noncopyable
+	bounded_pointer_ring(const bounded_pointer_ring&);
+	bounded_pointer_ring& operator =(const bounded_pointer_ring&);
+
+public:
+	bounded_pointer_ring() throw():
+		m_nEnqueuePos(0),
+		m_nDequeuePos(0)
+	{
+		for (size_t i = 0; i != Capacity; ++i)
+		{
+			m_cells[i].m_nSequence.store(i, std::memory_order_relaxed);
+			m_cells[i].m_p = 0;
+		}
+	}
+
+	/**	@short	Append @e p
+		@return	false if the ring is full
+	 */
+	bool try_push(void* p) throw()
+	{
+		size_t nPos = m_nEnqueuePos.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			cell& rCell = m_cells[nPos & (Capacity - 1)];
+			const size_t nSequence = rCell.m_nSequence.load(std::memory_order_acquire);
+			const ptrdiff_t nDiff = ptrdiff_t(nSequence) - ptrdiff_t(nPos);
+			if (nDiff == 0)
+			{
+				if (m_nEnqueuePos.compare_exchange_weak(nPos, nPos + 1, std::memory_order_relaxed))
+				{
+					rCell.m_p = p;
+					rCell.m_nSequence.store(nPos + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (nDiff < 0)
+				return false;
+			else
+				nPos = m_nEnqueuePos.load(std::memory_order_relaxed);
+		}
+	}
+
+	/**	@short	Remove the oldest pointer
+		@return	0 if the ring is empty
+	 */
+	void* try_pop() throw()
+	{
+		size_t nPos = m_nDequeuePos.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			cell& rCell = m_cells[nPos & (Capacity - 1)];
+			const size_t nSequence = rCell.m_nSequence.load(std::memory_order_acquire);
+			const ptrdiff_t nDiff = ptrdiff_t(nSequence) - ptrdiff_t(nPos + 1);
+			if (nDiff == 0)
+			{
+				if (m_nDequeuePos.compare_exchange_weak(nPos, nPos + 1, std::memory_order_relaxed))
+				{
+					void* p = rCell.m_p;
+					rCell.m_nSequence.store(nPos + Capacity, std::memory_order_release);
+					return p;
+				}
+			}
+			else if (nDiff < 0)
+				return 0;
+			else
+				nPos = m_nDequeuePos.load(std::memory_order_relaxed);
+		}
+	}
+
+	///	Number of pointers in the ring, approximate while other threads use it
+	size_t size() const throw()
+	{
+		const size_t nDequeuePos = m_nDequeuePos.load(std::memory_order_relaxed);
+		const size_t nEnqueuePos = m_nEnqueuePos.load(std::memory_order_relaxed);
+		return nEnqueuePos - nDequeuePos <= Capacity ? nEnqueuePos - nDequeuePos : 0;
+	}
+
+	/**	@short	Rebuild the ring from the pointers completely pushed, dropping
+		the slots of pushes and pops that never finished.
+
+		Requires exclusive access, e.g. in the child process after fork.
+	 */
+	void recover() throw()
+	{
+		void* pointers[Capacity];
+		size_t nCount = 0;
+		const size_t nEnd = m_nEnqueuePos.load(std::memory_order_relaxed);
+		for (size_t nPos = m_nDequeuePos.load(std::memory_order_relaxed); nPos != nEnd; ++nPos)
+		{
+			const cell& rCell = m_cells[nPos & (Capacity - 1)];
+			if (rCell.m_nSequence.load(std::memory_order_relaxed) == nPos + 1)
+				pointers[nCount++] = rCell.m_p;
+		}
+
+		m_nEnqueuePos.store(nCount, std::memory_order_relaxed);
+		m_nDequeuePos.store(0, std::memory_order_relaxed);
+		for (size_t i = 0; i != Capacity; ++i)
+		{
+			m_cells[i].m_nSequence.store(i < nCount ? i + 1 : i, std::memory_order_relaxed);
+			m_cells[i].m_p = i < nCount ? pointers[i] : 0;
+		}
+	}
+};
+
+}	// namespace detail
+
+}	// namespace kj
+
+
+#endif	// file guard
@@ -0,0 +1,253 @@
+/**	@file	Module-bound smart pointer factories.
+	Creates @c std::unique_ptr and @c std::shared_ptr instances whose memory
+	is freed in the module (shared module, executable) it was allocated in,
+	no matter which module releases the last reference.
+
+	@date	2026 10 17	kj	created
+ */
+
+#ifndef KJ_MODULEBOUND_MEMORY_H_INCLUDED
+#define KJ_MODULEBOUND_MEMORY_H_INCLUDED
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#  pragma once
+#endif
+
+#include <type_traits>
+#include <memory>	// std::unique_ptr, std::shared_ptr, std::allocate_shared
+#include <utility>	// std::forward
+#include "modulebound_allocator.h"
+
+
+namespace kj
+{
+
+namespace detail
+{
+
+// address of the complete object @e p is a subobject of;
+// a polymorphic object may be deleted through a pointer to one of its bases
+template<typename T> inline
+void* complete_object_address(T* p, std::true_type /*is_polymorphic*/) throw()
+{
+	return const_cast<void*>(dynamic_cast<const volatile void*>(p));
+}
+
+template<typename T> inline
+void* complete_object_address(T* p, std::false_type /*is_polymorphic*/) throw()
+{
+	return const_cast<void*>(static_cast<const volatile void*>(p));
+}
+
+// metafunction telling whether the first type of a parameter pack is a module-bound allocator
+template<typename... Args>
+struct leads_with_modulebound_allocator: std::false_type
+{};
+
+template<typename First, typename... Args>
+struct leads_with_modulebound_allocator<First, Args...>:
+	is_modulebound_allocator<typename std::remove_cv<typename std::remove_reference<First>::type>::type>
+{};
+
+}	// namespace detail
+
+
+/**	@short	Deleter for @c std::unique_ptr that destroys the object and frees
+	its memory with the raw deallocation function captured in the module
+	the object was allocated in.
+
+	In contrary to the module-bound allocator the deleter copies the raw
+	deallocation function when it is copied, so it can travel between
+	modules together with the pointer it belongs to.
+ */
+template<typename T>
+class module_deleter
+{
+	template<typename U> friend class module_deleter;
+
+	// stores operator delete of the allocating module
+	fp_raw_deallocate_t m_raw_deallocate;
+
+public:
+	/**	@short	Capture the raw deallocation function for single objects
+		available to the current translation unit.
+	 */
+	module_deleter() throw():
+		m_raw_deallocate(modulebound_allocator<T>().get_raw_operators().second)
+	{}
+
+	/**	@short	Use @e pfnDeallocate to free memory
+	 */
+	explicit module_deleter(fp_raw_deallocate_t pfnDeallocate) throw():
+		m_raw_deallocate(pfnDeallocate)
+	{}
+
+	/**	@short	Copy construct from deleters of derived types,
+		copy the raw deallocation function.
+	 */
+	template<typename U>
+	module_deleter(const module_deleter<U>& rOther,
+				   typename std::enable_if<std::is_convertible<U*, T*>::value>::type* = 0) throw():
+		m_raw_deallocate(rOther.m_raw_deallocate)
+	{}
+
+	/**	@short	Destroy the object at @e p and free its memory
+		@note	Deleting through a pointer to a base class requires
+		@c T to have a virtual destructor, as with @c delete.
+	 */
+	void operator ()(T* p) const throw()
+	{
+		void* pMemory = detail::complete_object_address(p, std::is_polymorphic<T>());
+		p->~T();
+		m_raw_deallocate(pMemory);
+	}
+
+	/**	@short	Make the raw deallocation function available to the caller
+	 */
+	fp_raw_deallocate_t get_raw_deallocate() const throw()
+	{
+		return m_raw_deallocate;
+	}
+};
+
+
+/**	@short	Specialization for arrays of unknown bound, remembers the number
+	of elements to destroy.
+ */
+template<typename T>
+class module_deleter<T[]>
+{
+	// stores operator delete[] of the allocating module
+	fp_raw_deallocate_t m_raw_deallocate;
+	// number of elements to destroy
+	size_t m_nCount;
+
+public:
+	module_deleter() throw():
+		m_raw_deallocate(modulebound_allocator<T[]>().get_raw_operators().second),
+		m_nCount(0)
+	{}
+
+	/**	@short	Use @e pfnDeallocate to free an array of @e nCount elements
+	 */
+	module_deleter(fp_raw_deallocate_t pfnDeallocate, size_t nCount) throw():
+		m_raw_deallocate(pfnDeallocate),
+		m_nCount(nCount)
+	{}
+
+	/**	@short	Destroy the elements in reverse order and free the array's memory
+	 */
+	void operator ()(T* p) const throw()
+	{
+		for (size_t i = m_nCount; i != 0; --i)
+			p[i - 1].~T();
+		m_raw_deallocate(p);
+	}
+
+	fp_raw_deallocate_t get_raw_deallocate() const throw()
+	{
+		return m_raw_deallocate;
+	}
+
+	size_t size() const throw()
+	{
+		return m_nCount;
+	}
+};
+
+
+/**	@short	@c std::unique_ptr freeing its object in the module it was allocated in
+ */
+template<typename T>
+using module_unique_ptr = std::unique_ptr<T, module_deleter<T> >;
+
+
+/**	@short	Create a single object owned by a @c module_unique_ptr.
+	@throw	@c std::bad_alloc, or any exception thrown by @c T's constructor
+ */
+template<typename T, typename... Args> inline
+typename std::enable_if<!std::is_array<T>::value, module_unique_ptr<T> >::type
+make_module_unique(Args&&... args)
+{
+	modulebound_allocator<T> a;
+	T* p = a.allocate(1);
+	try
+	{
+		::new (static_cast<void*>(p)) T(std::forward<Args>(args)...);
+	}
+	catch (...)
+	{
+		a.deallocate(p, 1);
+		throw;
+	}
+
+	return module_unique_ptr<T>(p, module_deleter<T>(a.get_raw_operators().second));
+}
+
+/**	@short	Create an array of @e nCount value-initialized objects owned by a
+	@c module_unique_ptr.
+	@throw	@c std::bad_alloc, or any exception thrown by @c T's constructor
+ */
+template<typename T> inline
+typename std::enable_if<std::is_array<T>::value && std::extent<T>::value == 0, module_unique_ptr<T> >::type
+make_module_unique(size_t nCount)
+{
+	typedef typename std::remove_extent<T>::type element_type;
+
+	modulebound_allocator<element_type[]> a;
+	element_type* p = a.allocate(nCount);
+	size_t i = 0;
+	try
+	{
+		for (; i != nCount; ++i)
+			::new (static_cast<void*>(p + i)) element_type();
+	}
+	catch (...)
+	{
+		while (i != 0)
+			p[--i].~element_type();
+		a.deallocate(p, nCount);
+		throw;
+	}
+
+	return module_unique_ptr<T>(p, module_deleter<T>(a.get_raw_operators().second, nCount));
+}
+
+// arrays of known bound are not supported, as with std::make_unique
+template<typename T, typename... Args>
+typename std::enable_if<std::extent<T>::value != 0>::type
+make_module_unique(Args&&...) = delete;
+
+
+/**	@short	Create an object owned by a @c std::shared_ptr, using @e a to
+	allocate the object and its control block in one single allocation.
+
+	The control block stores a copy of the allocator rebound to its own type
+	and is destroyed by a virtual function instantiated in the allocating
+	module; thus the memory is freed in the allocating module even if the
+	last @c std::shared_ptr is released in another one.
+
+	@throw	@c std::bad_alloc, or any exception thrown by @c T's constructor
+ */
+template<typename T, typename U, typename RawAllocation, typename... Args> inline
+std::shared_ptr<T> allocate_module_shared(const modulebound_allocator<U, RawAllocation>& a, Args&&... args)
+{
+	return std::allocate_shared<T>(a, std::forward<Args>(args)...);
+}
+
+/**	@short	Create an object owned by a @c std::shared_ptr in one single
+	allocation, using the module-bound allocator of the current module.
+	@throw	@c std::bad_alloc, or any exception thrown by @c T's constructor
+ */
+template<typename T, typename... Args> inline
+typename std::enable_if<!detail::leads_with_modulebound_allocator<Args...>::value, std::shared_ptr<T> >::type
+allocate_module_shared(Args&&... args)
+{
+	return std::allocate_shared<T>(modulebound_allocator<T>(), std::forward<Args>(args)...);
+}
+
+
+}	// namespace kj
+
+
+#endif	// file guard
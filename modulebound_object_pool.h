@@ -0,0 +1,285 @@
+/**	@file	Pool of constructed objects bound to the module that created the pool.
+
+	Reusing an idle object skips both the allocation and the reconstruction
+	of the capacity it has built up, e.g. the reserved storage of vectors
+	inside a request structure.
+
+	@code
+	struct request
+	{
+		std::vector<char, kj::modulebound_allocator<char[]> > body;
+		std::vector<header, kj::modulebound_allocator<header> > headers;
+	};
+
+	void reset_request(request& r)
+	{
+		// keep the capacity
+		r.body.clear();
+		r.headers.clear();
+	}
+
+	// host
+	kj::modulebound_object_pool<request> pool(&reset_request);
+	kj::modulebound_object_pool<request>::pointer p = pool.acquire();
+	plugin->handle(std::move(p));	// returns to the pool when the plugin drops it
+	@endcode
+
+	@date	2026 10 17	kj	created
+ */
+
+#ifndef KJ_MODULEBOUND_OBJECT_POOL_H_INCLUDED
+#define KJ_MODULEBOUND_OBJECT_POOL_H_INCLUDED
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#  pragma once
+#endif
+
+#include <memory>	// std::unique_ptr, std::shared_ptr
+#include <utility>	// std::move
+#include <new>
+#include <stddef.h>
+#include <stdint.h>	// uintptr_t
+#include "modulebound_allocator.h"
+#include "modulebound_lockfree.h"
+
+
+namespace kj
+{
+
+namespace detail
+{
+
+/**	@short	Interface objects are returned through.
+	The pool's implementation is reached via its virtual function table,
+	so an object dropped in another module is recycled by the code of the
+	pool's module.
+ */
+template<typename T>
+class object_pool_core
+{
+public:
+	virtual void recycle(T* p) throw() = 0;
+
+protected:
+	~object_pool_core() throw()
+	{}
+};
+
+
+// state shared by a pool and its outstanding objects
+template<typename T, size_t Capacity>
+class object_pool_state: public object_pool_core<T>
+{
+public:
+	typedef void (*fp_reset_t)(T&);
+
+private:
+	// captured once in the pool's module, never copied; 
+	// the pool outlives any region active while it is constructed
+	modulebound_allocator<T> m_allocator;
+	fp_reset_t m_pfnReset;
+	bounded_pointer_ring<Capacity> m_idle;
+
+	// noncopyable
+	object_pool_state(const object_pool_state&);
+	object_pool_state& operator =(const object_pool_state&);
+
+public:
+	explicit object_pool_state(fp_reset_t pfnReset) throw():
+		m_allocator(ignore_region),
+		m_pfnReset(pfnReset),
+		m_idle()
+	{}
+
+	~object_pool_state() throw()
+	{
+		while (void* p = m_idle.try_pop())
+			destroy(static_cast<T*>(p));
+	}
+
+	T* create()
+	{
+		T* p = m_allocator.allocate(1);
+		try
+		{
+			::new (static_cast<void*>(p)) T();
+		}
+		catch (...)
+		{
+			m_allocator.deallocate(p, 1);
+			throw;
+		}
+
+		return p;
+	}
+
+	void destroy(T* p) throw()
+	{
+		p->~T();
+		m_allocator.deallocate(p, 1);
+	}
+
+	T* acquire()
+	{
+		if (void* p = m_idle.try_pop())
+			return static_cast<T*>(p);
+		return create();
+	}
+
+	bool try_keep(T* p) throw()
+	{
+		return m_idle.try_push(p);
+	}
+
+	virtual void recycle(T* p) throw()
+	{
+		if (m_pfnReset)
+			m_pfnReset(*p);
+		if (!m_idle.try_push(p))
+			destroy(p);
+	}
+};
+
+
+/**	@short	Owns the storage of a pool's state.
+
+	The idle ring's members are aligned to cache lines, beyond the alignment
+	the allocators guarantee, so the state lives in an over-allocated block
+	of the pool's module and is constructed at its first suitably aligned
+	address.
+ */
+template<typename T, size_t Capacity>
+class object_pool_storage
+{
+public:
+	typedef object_pool_state<T, Capacity> state;
+	static const size_t block_size = sizeof(state) + alignof(state) - 1;
+
+private:
+	modulebound_allocator<char> m_allocator;
+	char* m_pBlock;
+
+public:
+	object_pool_storage(const modulebound_allocator<char>& rAllocator, char* pBlock) throw():
+		m_allocator(rAllocator),
+		m_pBlock(pBlock)
+	{}
+
+	void operator ()(state* p) throw()
+	{
+		p->~state();
+		m_allocator.deallocate(m_pBlock, block_size);
+	}
+
+	/**	@short	Create a state in an aligned block of the current module
+		@throw	@c std::bad_alloc
+	 */
+	static std::shared_ptr<state> create(typename state::fp_reset_t pfnReset)
+	{
+		modulebound_allocator<char> allocator(ignore_region);
+		char* pBlock = allocator.allocate(block_size);
+		const uintptr_t nAddress = (reinterpret_cast<uintptr_t>(pBlock) + alignof(state) - 1) & ~(alignof(state) - 1);
+		state* p = ::new (reinterpret_cast<void*>(nAddress)) state(pfnReset);
+		// destroys and frees the state if the shared count can't be allocated
+		return std::shared_ptr<state>(p, object_pool_storage(allocator, pBlock), allocator);
+	}
+};
+
+}	// namespace detail
+
+
+/**	@short	Deleter returning an object to the pool it was acquired from.
+	Keeps the pool's state alive as long as objects are outstanding.
+ */
+template<typename T>
+class object_pool_deleter
+{
+	std::shared_ptr<detail::object_pool_core<T> > m_pPool;
+
+public:
+	object_pool_deleter() throw():
+		m_pPool()
+	{}
+
+	explicit object_pool_deleter(const std::shared_ptr<detail::object_pool_core<T> >& pPool) throw():
+		m_pPool(pPool)
+	{}
+
+	void operator ()(T* p) const throw()
+	{
+		m_pPool->recycle(p);
+	}
+};
+
+
+/**	@short	Pool of constructed but idle objects of type @c T, keeping at most
+	@c Capacity idle objects.
+
+	Objects are allocated through the module-bound allocator of the module
+	that constructed the pool, and are handed out as a @c std::unique_ptr
+	which recycles the object when dropped, in whichever module.
+	An optional reset function is applied to a returned object before it is
+	kept for reuse; it should clear the object's contents but keep its
+	capacity.
+
+	Acquiring and returning objects is lock-free; if more than @c Capacity
+	objects are idle a returned object is destroyed.
+	The pool may be destroyed while objects are still outstanding, the
+	objects are then destroyed when dropped.
+ */
+template<typename T, size_t Capacity = 64>
+class modulebound_object_pool
+{
+	typedef detail::object_pool_state<T, Capacity> state;
+
+public:
+	typedef typename state::fp_reset_t fp_reset_t;
+	typedef std::unique_ptr<T, object_pool_deleter<T> > pointer;
+
+
+private:
+	std::shared_ptr<state> m_pState;
+
+	// noncopyable
+	modulebound_object_pool(const modulebound_object_pool&);
+	modulebound_object_pool& operator =(const modulebound_object_pool&);
+
+public:
+	/**	@short	Construct an empty pool bound to the current module
+		@param	pfnReset	applied to returned objects, may be 0
+		@throw	@c std::bad_alloc
+	 */
+	explicit modulebound_object_pool(fp_reset_t pfnReset = 0):
+		m_pState(detail::object_pool_storage<T, Capacity>::create(pfnReset))
+	{}
+
+	/**	@short	Hand out an idle object or a new default-constructed one
+		@throw	@c std::bad_alloc, or any exception thrown by @c T's constructor
+	 */
+	pointer acquire()
+	{
+		return pointer(m_pState->acquire(), object_pool_deleter<T>(m_pState));
+	}
+
+	/**	@short	Create up to @e nCount idle objects in advance
+		@throw	@c std::bad_alloc, or any exception thrown by @c T's constructor
+	 */
+	void reserve(size_t nCount)
+	{
+		for (size_t i = 0; i != nCount; ++i)
+		{
+			T* p = m_pState->create();
+			if (!m_pState->try_keep(p))
+			{
+				m_pState->destroy(p);
+				break;
+			}
+		}
+	}
+};
+
+
+}	// namespace kj
+
+
+#endif	// file guard
@@ -0,0 +1,291 @@
+/**	@file	Size-class pool backing the module-bound allocator's arenas.
+
+	@date	2026 10 17	kj	created
+ */
+
+#ifndef KJ_MODULEBOUND_POOL_H_INCLUDED
+#define KJ_MODULEBOUND_POOL_H_INCLUDED
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#  pragma once
+#endif
+
+#include <type_traits>
+#include <mutex>
+#include <cstddef>	// std::max_align_t
+#include <stddef.h>
+#include "modulebound_allocator_fwddecl.h"
+#include "modulebound_lifecycle.h"
+#if defined(KJ_MODULEBOUND_POOL_SIZE_CLASSES)
+// size class table generated by tools/size_class_generator.cpp
+#  include KJ_MODULEBOUND_POOL_SIZE_CLASSES
+#endif
+
+
+namespace kj
+{
+
+namespace detail
+{
+
+// block sizes of the pool are multiples of pool_granularity up to pool_max_block_size
+const size_t pool_granularity = 16;
+const size_t pool_max_block_size = 1024;
+// size of a chunk, the unit the pool gets from the heap
+const size_t pool_chunk_size = 64 * 1024;
+
+
+/**	@short	Default size classes of the pools: every multiple of
+	@c pool_granularity.
+
+	A module defining @c KJ_MODULEBOUND_POOL_SIZE_CLASSES as the path of a
+	header generated by @c tools/size_class_generator.cpp uses the classes
+	of that header (@c generated_size_classes) instead; the macro must be
+	the same in all translation units of the module.
+ */
+struct uniform_size_classes
+{
+	static const size_t count = pool_max_block_size / pool_granularity;
+
+	///	The class serving blocks of @e nBytes
+	static constexpr size_t index(size_t nBytes)
+	{
+		return nBytes ? (nBytes - 1) / pool_granularity : 0;
+	}
+
+	///	The block size of class @e nIndex
+	static constexpr size_t size(size_t nIndex)
+	{
+		return (nIndex + 1) * pool_granularity;
+	}
+};
+
+#if defined(KJ_MODULEBOUND_POOL_SIZE_CLASSES)
+typedef generated_size_classes pool_size_classes;
+static_assert(pool_size_classes::granularity == pool_granularity, "generated size classes don't match the pool's granularity");
+static_assert(pool_size_classes::size(pool_size_classes::count - 1) == pool_max_block_size, "generated size classes don't cover the pool's blocks");
+#else
+typedef uniform_size_classes pool_size_classes;
+#endif
+
+const size_t pool_class_count = pool_size_classes::count;
+
+// the class serving blocks of nBytes (served by the pools), resolved at compile time
+template<size_t nBytes>
+struct pool_class_of: std::integral_constant<
+	size_t, 
+	pool_size_classes::index(nBytes <= pool_max_block_size ? nBytes : pool_max_block_size)
+>
+{};
+
+
+/**	@short	Lock policy for pools shared between threads
+ */
+typedef std::mutex pool_mutex;
+
+
+/**	@short	Pool of small blocks carved off chunks of the module's heap, one
+	free list per size class.
+
+	Blocks up to @c pool_max_block_size bytes are served by the pool, the
+	caller serves larger ones. Chunks are given back when the pool is closed
+	or, if blocks are still in use then, once the last block is freed.
+	@c Lock is a BasicLockable type guarding the pool.
+ */
+template<typename Lock>
+class size_class_pool
+{
+	struct chunk
+	{
+		chunk* m_pNext;
+	};
+
+	struct free_block
+	{
+		free_block* m_pNext;
+	};
+
+	static const size_t header_size = (sizeof(chunk) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+
+	Lock m_lock;
+	fp_raw_allocate_t m_pfnAllocate;
+	fp_raw_deallocate_t m_pfnDeallocate;
+	free_block* m_free[pool_class_count];
+	char* m_pCursor;
+	char* m_pEnd;
+	chunk* m_pChunks;
+	size_t m_nLive;
+	size_t m_nLiveBytes;
+	bool m_bClosed;
+
+	// noncopyable
+	size_class_pool(const size_class_pool&);
+	size_class_pool& operator =(const size_class_pool&);
+
+	static size_t class_index(size_t nBytes) throw()
+	{
+		return pool_size_classes::index(nBytes);
+	}
+
+	// give the chunks back, requires the lock
+	void free_chunks() throw()
+	{
+		while (chunk* pChunk = m_pChunks)
+		{
+			m_pChunks = pChunk->m_pNext;
+			m_pfnDeallocate(pChunk);
+		}
+		for (size_t i = 0; i != pool_class_count; ++i)
+			m_free[i] = 0;
+		m_pCursor = m_pEnd = 0;
+	}
+
+public:
+	/**	@short	Construct an empty pool getting its chunks from @e pfnAllocate
+	 */
+	size_class_pool(fp_raw_allocate_t pfnAllocate, fp_raw_deallocate_t pfnDeallocate) throw():
+		m_lock(),
+		m_pfnAllocate(pfnAllocate),
+		m_pfnDeallocate(pfnDeallocate),
+		m_pCursor(0),
+		m_pEnd(0),
+		m_pChunks(0),
+		m_nLive(0),
+		m_nLiveBytes(0),
+		m_bClosed(false)
+	{
+		for (size_t i = 0; i != pool_class_count; ++i)
+			m_free[i] = 0;
+	}
+
+	///	The lock policy guarding the pool
+	Lock& get_lock() throw()
+	{
+		return m_lock;
+	}
+
+	///	Whether blocks of @e nBytes are served by the pool
+	static bool serves(size_t nBytes) throw()
+	{
+		return nBytes <= pool_max_block_size;
+	}
+
+	/**	@short	Allocate a block of @e nBytes (served by the pool)
+		@throw	@c std::bad_alloc
+	 */
+	void* allocate(size_t nBytes)
+	{
+		return allocate_class(class_index(nBytes));
+	}
+
+	/**	@short	Allocate a block of size class @e nIndex
+		@throw	@c std::bad_alloc
+	 */
+	void* allocate_class(size_t nIndex)
+	{
+		const size_t nBlockSize = pool_size_classes::size(nIndex);
+		std::lock_guard<Lock> lock(m_lock);
+
+		void* p;
+		if (free_block* pBlock = m_free[nIndex])
+		{
+			m_free[nIndex] = pBlock->m_pNext;
+			p = pBlock;
+		}
+		else
+		{
+			if (size_t(m_pEnd - m_pCursor) < nBlockSize)
+			{
+				// the rest of the current chunk is lost
+				chunk* pChunk = static_cast<chunk*>(m_pfnAllocate(pool_chunk_size));
+				pChunk->m_pNext = m_pChunks;
+				m_pChunks = pChunk;
+				m_pCursor = reinterpret_cast<char*>(pChunk) + header_size;
+				m_pEnd = reinterpret_cast<char*>(pChunk) + pool_chunk_size;
+			}
+
+			p = m_pCursor;
+			m_pCursor += nBlockSize;
+		}
+
+		++m_nLive;
+		m_nLiveBytes += nBlockSize;
+		return p;
+	}
+
+	///	Free a block of @e nBytes (served by the pool)
+	void deallocate(void* p, size_t nBytes) throw()
+	{
+		deallocate_class(p, class_index(nBytes));
+	}
+
+	///	Free a block of size class @e nIndex
+	void deallocate_class(void* p, size_t nIndex) throw()
+	{
+		if (!p)
+			return;
+
+		free_block* pBlock = static_cast<free_block*>(p);
+		std::lock_guard<Lock> lock(m_lock);
+		pBlock->m_pNext = m_free[nIndex];
+		m_free[nIndex] = pBlock;
+		m_nLiveBytes -= pool_size_classes::size(nIndex);
+
+		if (!--m_nLive && m_bClosed)
+			free_chunks();
+	}
+
+	///	Add the pool's memory to @e rStats
+	void add_statistics(module_cache_statistics& rStats)
+	{
+		std::lock_guard<Lock> lock(m_lock);
+		for (chunk* pChunk = m_pChunks; pChunk; pChunk = pChunk->m_pNext)
+			rStats.m_nReservedBytes += pool_chunk_size;
+		rStats.m_nUsedBytes += m_nLiveBytes;
+		for (size_t i = 0; i != pool_class_count; ++i)
+			for (free_block* pBlock = m_free[i]; pBlock; pBlock = pBlock->m_pNext)
+				rStats.m_nFreeBytes += pool_size_classes::size(i);
+	}
+
+	///	Give the chunks back if no block is in use
+	void trim() throw()
+	{
+		std::lock_guard<Lock> lock(m_lock);
+		if (!m_nLive)
+			free_chunks();
+	}
+
+	///	Give the chunks back now or once the last block is freed
+	void close() throw()
+	{
+		std::lock_guard<Lock> lock(m_lock);
+		m_bClosed = true;
+		if (!m_nLive)
+			free_chunks();
+	}
+};
+
+
+/**	@short	Closes a pool when the module exits
+ */
+template<typename Pool>
+struct pool_closer
+{
+	Pool& m_rPool;
+
+	explicit pool_closer(Pool& rPool) throw():
+		m_rPool(rPool)
+	{}
+
+	~pool_closer() throw()
+	{
+		m_rPool.close();
+	}
+};
+
+}	// namespace detail
+
+}	// namespace kj
+
+
+#endif	// file guard
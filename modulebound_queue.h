@@ -0,0 +1,268 @@
+/**	@file	Bounded lock-free multi-producer/multi-consumer queue shared
+	between modules.
+
+	The queue's cells are allocated once, by the module-bound allocator of
+	the module constructing the queue, and are reused lap after lap; passing
+	messages through the queue doesn't touch the heap, and the cells go back
+	to the constructing module when the queue is destroyed, whichever module
+	destroys it.
+
+	@code
+	// host
+	kj::modulebound_queue<message> bus(4096);
+
+	// plugins, on any thread
+	if (!bus.try_push(message(...)))
+		handle_backpressure();
+
+	message m;
+	while (bus.try_pop(m))
+		dispatch(m);
+	@endcode
+
+	@date	2026 10 17	kj	created
+ */
+
+#ifndef KJ_MODULEBOUND_QUEUE_H_INCLUDED
+#define KJ_MODULEBOUND_QUEUE_H_INCLUDED
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#  pragma once
+#endif
+
+#include <type_traits>
+#include <atomic>
+#include <memory>	// std::allocator_traits
+#include <utility>	// std::move, std::forward
+#include <new>
+#include <stdexcept>	// std::length_error
+#include <stddef.h>
+#include "modulebound_allocator.h"
+#include "modulebound_lockfree.h"
+
+
+namespace kj
+{
+
+/**	@short	Bounded lock-free multi-producer/multi-consumer queue of @c T
+	(Dmitry Vyukov's bounded MPMC queue, like @c detail::bounded_pointer_ring,
+	holding values).
+
+	The capacity is rounded up to a power of two. Pushing fails if the queue
+	is full, popping fails if it is empty; neither blocks nor allocates.
+	Elements are constructed by the producer before a cell is claimed and
+	moved in and out of the cells, which requires @c T's move constructor
+	and move assignment not to throw.
+
+	@c Allocator is rebound to the cell type; with the default
+	module-bound allocator the cells belong to the constructing module.
+ */
+template<typename T, typename Allocator = modulebound_allocator<T> >
+class modulebound_queue
+{
+	static_assert(std::is_nothrow_move_constructible<T>::value, "the queue moves elements into claimed cells, the move must not throw");
+	static_assert(std::is_nothrow_move_assignable<T>::value, "the queue moves elements out of claimed cells, the move must not throw");
+
+public:
+	typedef T value_type;
+	typedef size_t size_type;
+	typedef Allocator allocator_type;
+
+
+private:
+	struct cell
+	{
+		std::atomic<size_t> m_nSequence;
+		typename std::aligned_storage<sizeof(T), alignof(T)>::type m_storage;
+
+		T& value() throw()
+		{
+			return *reinterpret_cast<T*>(&m_storage);
+		}
+	};
+
+	typedef typename std::allocator_traits<Allocator>::template rebind_alloc<cell> cell_allocator;
+	typedef std::allocator_traits<cell_allocator> cell_traits;
+
+	cell_allocator m_allocator;
+	cell* m_pCells;
+	const size_t m_nMask;
+	alignas(detail::cache_line_size) std::atomic<size_t> m_nEnqueuePos;
+	alignas(detail::cache_line_size) std::atomic<size_t> m_nDequeuePos;
+
+	// noncopyable
+	modulebound_queue(const modulebound_queue&);
+	modulebound_queue& operator =(const modulebound_queue&);
+
+	static size_t round_capacity(size_t nCapacity)
+	{
+		size_t n = 2;
+		while (n < nCapacity)
+		{
+			if (n > size_t(-1) / 2 / sizeof(cell))
+				throw std::length_error("kj::modulebound_queue");
+			n <<= 1;
+		}
+		return n;
+	}
+
+	// claim the next cell for writing
+	cell* claim_push() throw()
+	{
+		size_t nPos = m_nEnqueuePos.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			cell& rCell = m_pCells[nPos & m_nMask];
+			const size_t nSequence = rCell.m_nSequence.load(std::memory_order_acquire);
+			const ptrdiff_t nDiff = ptrdiff_t(nSequence) - ptrdiff_t(nPos);
+			if (nDiff == 0)
+			{
+				if (m_nEnqueuePos.compare_exchange_weak(nPos, nPos + 1, std::memory_order_relaxed))
+					return &rCell;
+			}
+			else if (nDiff < 0)
+				return 0;
+			else
+				nPos = m_nEnqueuePos.load(std::memory_order_relaxed);
+		}
+	}
+
+	// claim the oldest cell for reading
+	cell* claim_pop(size_t& rnPos) throw()
+	{
+		size_t nPos = m_nDequeuePos.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			cell& rCell = m_pCells[nPos & m_nMask];
+			const size_t nSequence = rCell.m_nSequence.load(std::memory_order_acquire);
+			const ptrdiff_t nDiff = ptrdiff_t(nSequence) - ptrdiff_t(nPos + 1);
+			if (nDiff == 0)
+			{
+				if (m_nDequeuePos.compare_exchange_weak(nPos, nPos + 1, std::memory_order_relaxed))
+				{
+					rnPos = nPos;
+					return &rCell;
+				}
+			}
+			else if (nDiff < 0)
+				return 0;
+			else
+				nPos = m_nDequeuePos.load(std::memory_order_relaxed);
+		}
+	}
+
+public:
+	/**	@short	Construct an empty queue holding up to @e nCapacity elements
+		(rounded up to a power of two), allocating the cells with
+		@e rAllocator
+		@throw	@c std::bad_alloc, @c std::length_error
+	 */
+	explicit modulebound_queue(size_type nCapacity, const Allocator& rAllocator = Allocator()):
+		m_allocator(rAllocator),
+		m_pCells(0),
+		m_nMask(round_capacity(nCapacity) - 1),
+		m_nEnqueuePos(0),
+		m_nDequeuePos(0)
+	{
+		m_pCells = cell_traits::allocate(m_allocator, m_nMask + 1);
+		for (size_t i = 0; i <= m_nMask; ++i)
+			::new (static_cast<void*>(&m_pCells[i].m_nSequence)) std::atomic<size_t>(i);
+	}
+
+	/**	@short	Destroy the remaining elements and free the cells through the
+		allocator they were allocated with
+
+		No other thread may use the queue anymore.
+	 */
+	~modulebound_queue() throw()
+	{
+		const size_t nEnd = m_nEnqueuePos.load(std::memory_order_relaxed);
+		for (size_t nPos = m_nDequeuePos.load(std::memory_order_relaxed); nPos != nEnd; ++nPos)
+			m_pCells[nPos & m_nMask].value().~T();
+		cell_traits::deallocate(m_allocator, m_pCells, m_nMask + 1);
+	}
+
+	///	Maximum number of elements
+	size_type capacity() const throw()
+	{
+		return m_nMask + 1;
+	}
+
+	///	Number of elements, approximate while other threads use the queue
+	size_type size() const throw()
+	{
+		const size_t nDequeuePos = m_nDequeuePos.load(std::memory_order_relaxed);
+		const size_t nEnqueuePos = m_nEnqueuePos.load(std::memory_order_relaxed);
+		return nEnqueuePos - nDequeuePos <= m_nMask + 1 ? nEnqueuePos - nDequeuePos : 0;
+	}
+
+	///	Whether the queue is empty, approximate while other threads use it
+	bool empty() const throw()
+	{
+		return !size();
+	}
+
+	/**	@short	Append @e value
+		@return	false if the queue is full, @e value is left untouched then
+	 */
+	bool try_push(T&& value) throw()
+	{
+		cell* pCell = claim_push();
+		if (!pCell)
+			return false;
+
+		const size_t nPos = pCell->m_nSequence.load(std::memory_order_relaxed);
+		::new (static_cast<void*>(&pCell->m_storage)) T(std::move(value));
+		pCell->m_nSequence.store(nPos + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**	@short	Append a copy of @e value
+		@return	false if the queue is full
+		@throw	Any exception thrown by @c T's copy constructor
+	 */
+	bool try_push(const T& value)
+	{
+		T copy(value);
+		return try_push(std::move(copy));
+	}
+
+	/**	@short	Append an element constructed from @e args
+		@return	false if the queue is full
+		@throw	Any exception thrown by @c T's constructor
+	 */
+	template<typename... Args>
+	bool try_emplace(Args&&... args)
+	{
+		T value(std::forward<Args>(args)...);
+		return try_push(std::move(value));
+	}
+
+	/**	@short	Move the oldest element to @e rValue
+		@return	false if the queue is empty
+	 */
+	bool try_pop(T& rValue) throw()
+	{
+		size_t nPos;
+		cell* pCell = claim_pop(nPos);
+		if (!pCell)
+			return false;
+
+		rValue = std::move(pCell->value());
+		pCell->value().~T();
+		pCell->m_nSequence.store(nPos + m_nMask + 1, std::memory_order_release);
+		return true;
+	}
+
+	///	The allocator the cells were allocated with
+	allocator_type get_allocator() const throw()
+	{
+		return allocator_type(m_allocator);
+	}
+};
+
+
+}	// namespace kj
+
+
+#endif	// file guard
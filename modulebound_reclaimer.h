@@ -0,0 +1,303 @@
+/**	@file	Deferred destruction of module-bound containers on a background thread.
+
+	Tearing down a huge node container means one deallocation per node;
+	handing the container to the module's reclaimer thread takes that work
+	off the calling thread. The container's allocator moves along with its
+	storage, so the nodes are still freed by the module that allocated them.
+
+	@code
+	void request_done(session& s)
+	{
+		// s.index: std::map<key, value, std::less<key>, kj::modulebound_allocator<std::pair<const key, value> > >
+		kj::defer_destroy(std::move(s.index));
+	}
+	@endcode
+
+	@date	2026 10 17	kj	created
+ */
+
+#ifndef KJ_MODULEBOUND_RECLAIMER_H_INCLUDED
+#define KJ_MODULEBOUND_RECLAIMER_H_INCLUDED
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#  pragma once
+#endif
+
+#include <type_traits>
+#include <utility>	// std::move
+#include <mutex>
+#include <condition_variable>
+#include <new>
+#include <thread>
+#include "modulebound_allocator.h"
+#include "modulebound_lifecycle.h"
+
+
+namespace kj
+{
+
+template<raw_allocation_type C>
+struct unsynchronized_pool_allocation;
+
+
+namespace detail
+{
+
+// metafunction telling whether allocators of type A are confined to one thread
+template<typename A>
+struct is_thread_confined_allocator: std::false_type
+{};
+
+template<typename T, raw_allocation_type C>
+struct is_thread_confined_allocator<modulebound_allocator<T, unsynchronized_pool_allocation<C> > >: std::true_type
+{};
+
+
+// a container waiting for destruction, linked into the reclaimer's pending list
+class deferred_destruction
+{
+public:
+	deferred_destruction* m_pNext;
+
+	deferred_destruction() throw():
+		m_pNext(0)
+	{}
+
+	virtual ~deferred_destruction() throw()
+	{}
+};
+
+template<typename Container>
+class deferred_container: public deferred_destruction
+{
+	Container m_container;
+
+public:
+	explicit deferred_container(Container&& rContainer):
+		m_container(std::move(rContainer))
+	{}
+};
+
+
+/**	@short	Per-module thread destroying deferred containers.
+
+	The thread is started by the first deferred container; each time it
+	wakes up it takes all pending containers as one batch and destroys them
+	outside the lock.
+	The reclaimer is stopped when the module exits; it then destroys what's
+	still pending, and containers deferred afterwards are destroyed on the
+	calling thread. It is never destroyed, so containers deferred during
+	static destruction find it intact.
+ */
+class reclaimer
+{
+	std::mutex m_mutex;
+	std::condition_variable m_wakeup;
+	std::condition_variable m_idle;
+	deferred_destruction* m_pPending;
+	bool m_bBusy;
+	bool m_bStopped;
+	std::thread m_thread;
+
+	reclaimer() throw():
+		m_pPending(0),
+		m_bBusy(false),
+		m_bStopped(false)
+	{}
+
+	// noncopyable
+	reclaimer(const reclaimer&);
+	reclaimer& operator =(const reclaimer&);
+
+	struct closer
+	{
+		reclaimer& m_rReclaimer;
+
+		explicit closer(reclaimer& rReclaimer) throw():
+			m_rReclaimer(rReclaimer)
+		{}
+
+		~closer() throw()
+		{
+			m_rReclaimer.stop();
+		}
+	};
+
+	static void destroy_batch(deferred_destruction* p) throw()
+	{
+		while (p)
+		{
+			deferred_destruction* pNext = p->m_pNext;
+			delete p;
+			p = pNext;
+		}
+	}
+
+	void run() throw()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		for (;;)
+		{
+			while (!m_pPending && !m_bStopped)
+				m_wakeup.wait(lock);
+			if (!m_pPending)
+				break;
+
+			deferred_destruction* pBatch = m_pPending;
+			m_pPending = 0;
+			m_bBusy = true;
+
+			lock.unlock();
+			destroy_batch(pBatch);
+			lock.lock();
+
+			m_bBusy = false;
+			if (!m_pPending)
+				m_idle.notify_all();
+		}
+	}
+
+public:
+	///	The reclaimer of the current module
+	static reclaimer& instance()
+	{
+		static std::aligned_storage<sizeof(reclaimer), alignof(reclaimer)>::type s_storage;
+		static reclaimer* s_pReclaimer = ::new (static_cast<void*>(&s_storage)) reclaimer();
+		static closer s_closer(*s_pReclaimer);
+		register_fork_handlers<&lock_reclaimer, &unlock_reclaimer, &reset_in_child>();
+		return *s_pReclaimer;
+	}
+
+	static void lock_reclaimer()
+	{
+		instance().m_mutex.lock();
+	}
+
+	static void unlock_reclaimer()
+	{
+		instance().m_mutex.unlock();
+	}
+
+	// the thread doesn't exist in the child; the next post starts a new one,
+	// a batch it was destroying is lost
+	static void reset_in_child()
+	{
+		reclaimer& rReclaimer = instance();
+		::new (static_cast<void*>(&rReclaimer.m_thread)) std::thread();
+		::new (static_cast<void*>(&rReclaimer.m_wakeup)) std::condition_variable();
+		::new (static_cast<void*>(&rReclaimer.m_idle)) std::condition_variable();
+		rReclaimer.m_bBusy = false;
+		rReclaimer.m_mutex.unlock();
+	}
+
+	/**	@short	Queue @e p for destruction
+		@return	false if the reclaimer is stopped
+		@throw	@c std::system_error if the thread can't be started
+	 */
+	bool post(deferred_destruction* p)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_bStopped)
+			return false;
+		if (!m_thread.joinable())
+			m_thread = std::thread(&reclaimer::run, this);
+
+		p->m_pNext = m_pPending;
+		m_pPending = p;
+		m_wakeup.notify_one();
+		return true;
+	}
+
+	///	Wait until all containers deferred so far are destroyed
+	void flush()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		if (!m_thread.joinable())
+			return;
+		while (m_pPending || m_bBusy)
+			m_idle.wait(lock);
+	}
+
+	///	Destroy the pending containers and end the thread
+	void stop() throw()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_bStopped = true;
+			m_wakeup.notify_one();
+		}
+
+		if (m_thread.joinable())
+			m_thread.join();
+	}
+};
+
+}	// namespace detail
+
+
+/**	@short	Destroy a container using the module-bound allocator on the
+	current module's reclaimer thread.
+
+	The container is moved (including its allocator) and @e rContainer is
+	left in the moved-from state. If the container can't be handed to the
+	reclaimer it is destroyed on the calling thread.
+
+	@attention	The reclaimer runs code of the current module, so containers
+	with element types of another module must be deferred by that module.
+	The reclaimer thread is joined when the current module exits; on Windows
+	a dll must call stop_deferred_destroy() before it is unloaded, as
+	threads can't be joined while the loader lock is held.
+	@attention	The container is destroyed on another thread, so it must not
+	allocate from a thread-confined pool or region: containers of the
+	unsynchronized pool allocation mode are rejected at compile time,
+	containers bound to a region (see modulebound_region.h), or holding
+	such containers, must not be deferred.
+ */
+template<typename Container> inline
+typename std::enable_if<detail::is_modulebound_container<Container>::value>::type
+defer_destroy(Container&& rContainer)
+{
+	static_assert(!detail::is_thread_confined_allocator<typename Container::allocator_type>::value, "the reclaimer thread can't free into a thread-confined pool");
+
+	detail::deferred_destruction* p = 0;
+	try
+	{
+		p = new detail::deferred_container<Container>(std::move(rContainer));
+		if (detail::reclaimer::instance().post(p))
+			return;
+	}
+	catch (...)
+	{
+		if (!p)
+		{
+			Container discarded(std::move(rContainer));
+			return;
+		}
+	}
+
+	delete p;
+}
+
+/**	@short	Wait until all containers deferred by the current module are destroyed
+ */
+inline
+void flush_deferred_destroy()
+{
+	detail::reclaimer::instance().flush();
+}
+
+/**	@short	Destroy all containers deferred by the current module and end
+	its reclaimer thread; containers deferred afterwards are destroyed
+	on the calling thread.
+ */
+inline
+void stop_deferred_destroy() throw()
+{
+	detail::reclaimer::instance().stop();
+}
+
+
+}	// namespace kj
+
+
+#endif	// file guard
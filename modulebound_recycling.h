@@ -0,0 +1,235 @@
+/**	@file	Return-to-sender recycling allocation mode for the module-bound allocator.
+
+	Blocks freed by a consumer are not given back to the heap but pushed onto
+	a lock-free ring of the producing module, where the next allocation of
+	the same size class picks them up again. In a producer/consumer pipeline
+	in steady state no heap call happens at all.
+
+	@code
+	typedef kj::modulebound_allocator<char[], kj::recycling_allocation<64> > payload_allocator;
+	typedef std::vector<char, payload_allocator> payload;
+
+	// plugin A produces payloads, plugin B consumes and destroys them;
+	// B's deallocation returns the storage to A's recycling pool
+	@endcode
+
+	@date	2026 10 17	kj	created
+ */
+
+#ifndef KJ_MODULEBOUND_RECYCLING_H_INCLUDED
+#define KJ_MODULEBOUND_RECYCLING_H_INCLUDED
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#  pragma once
+#endif
+
+#include <type_traits>
+#include <atomic>
+#include <stddef.h>
+#include "modulebound_allocator.h"
+#include "modulebound_lockfree.h"
+#include "modulebound_lifecycle.h"
+
+
+namespace kj
+{
+
+/**	@short	Allocation mode recycling up to @c Depth freed blocks per size class
+	in the allocating module.
+
+	Requests are rounded up to the next power of two (at least 64 bytes) so
+	any recycled block of a class satisfies any request of that class;
+	requests larger than 16 MiB bypass recycling.
+	If a class' ring is full a freed block goes back to the heap, which
+	bounds the memory held by the pool.
+
+	The allocation mode is passed as the @c RawAllocation parameter and is
+	preserved when rebinding; @c C chooses the array or single object
+	operators used to get blocks from the heap.
+ */
+template<size_t Depth, raw_allocation_type C = raw_allocation_array>
+struct recycling_allocation: std::integral_constant<raw_allocation_type, C>
+{};
+
+
+namespace detail
+{
+
+// size classes of the recycling pool are the powers of two
+// between 2^recycling_min_class_log2 and 2^recycling_max_class_log2
+const size_t recycling_min_class_log2 = 6;
+const size_t recycling_max_class_log2 = 24;
+const size_t recycling_class_count = recycling_max_class_log2 - recycling_min_class_log2 + 1;
+
+// index of the smallest size class holding nBytes (nBytes <= 2^recycling_max_class_log2)
+inline
+size_t recycling_class_index(size_t nBytes) throw()
+{
+	size_t nIndex = 0;
+	for (size_t nClassSize = size_t(1) << recycling_min_class_log2; nClassSize < nBytes; nClassSize <<= 1)
+		++nIndex;
+	return nIndex;
+}
+
+
+/**	@short	Per-module pool of freed blocks, one bounded ring per size class.
+
+	The pool is never destroyed (it is trivially destructible) so blocks freed
+	during static destruction find it intact; closing it at module exit gives
+	the cached blocks back to the heap and lets later frees bypass the rings.
+ */
+template<size_t Depth, bool IsArray>
+class recycling_pool
+{
+	bounded_pointer_ring<Depth> m_rings[recycling_class_count];
+	std::atomic<bool> m_bClosed;
+
+	recycling_pool() throw():
+		m_bClosed(false)
+	{}
+
+	struct closer
+	{
+		recycling_pool& m_rPool;
+
+		explicit closer(recycling_pool& rPool) throw():
+			m_rPool(rPool)
+		{}
+
+		~closer() throw()
+		{
+			m_rPool.close();
+		}
+	};
+
+public:
+	///	The pool of the current module
+	static recycling_pool& instance()
+	{
+		static recycling_pool s_pool;
+		static closer s_closer(s_pool);
+		register_module_cache<&flush, &statistics>();
+		register_fork_handlers<&ignore_fork, &ignore_fork, &recover>();
+		return s_pool;
+	}
+
+	///	Add the blocks cached by the current module's pool to @e rStats
+	static void statistics(module_cache_statistics& rStats)
+	{
+		recycling_pool& rPool = instance();
+		for (size_t i = 0; i != recycling_class_count; ++i)
+		{
+			const size_t nBytes = rPool.m_rings[i].size() << (i + recycling_min_class_log2);
+			rStats.m_nReservedBytes += nBytes;
+			rStats.m_nFreeBytes += nBytes;
+		}
+	}
+
+	// in the child, drop the ring slots of threads interrupted by fork
+	static void recover()
+	{
+		recycling_pool& rPool = instance();
+		for (size_t i = 0; i != recycling_class_count; ++i)
+			rPool.m_rings[i].recover();
+	}
+
+	///	Give the blocks cached by the current module's pool back to the heap
+	static void flush()
+	{
+		recycling_pool& rPool = instance();
+		for (size_t i = 0; i != recycling_class_count; ++i)
+			while (void* p = rPool.m_rings[i].try_pop())
+				fetch_module_ops(IsArray)->deallocate(p);
+	}
+
+	void* allocate(size_t nBytes)
+	{
+		if (nBytes > (size_t(1) << recycling_max_class_log2))
+			return fetch_module_ops(IsArray)->allocate(nBytes);
+
+		const size_t nIndex = recycling_class_index(nBytes);
+		if (void* p = m_rings[nIndex].try_pop())
+			return p;
+		return fetch_module_ops(IsArray)->allocate(size_t(1) << (nIndex + recycling_min_class_log2));
+	}
+
+	void deallocate(void* p, size_t nBytes) throw()
+	{
+		if (nBytes > (size_t(1) << recycling_max_class_log2) ||
+			m_bClosed.load(std::memory_order_acquire) ||
+			!m_rings[recycling_class_index(nBytes)].try_push(p))
+			fetch_module_ops(IsArray)->deallocate(p);
+	}
+
+	///	Give all cached blocks back to the heap, stop recycling
+	void close() throw()
+	{
+		m_bClosed.store(true, std::memory_order_release);
+		for (size_t i = 0; i != recycling_class_count; ++i)
+			while (void* p = m_rings[i].try_pop())
+				fetch_module_ops(IsArray)->deallocate(p);
+	}
+};
+
+
+// raw memory operations of the recycling allocation mode
+template<size_t Depth, bool IsArray>
+struct recycling_ops
+{
+	static void* allocate(size_t nBytes)
+	{
+		return recycling_pool<Depth, IsArray>::instance().allocate(nBytes);
+	}
+
+	static void* ops_allocate(const module_ops*, size_t nBytes)
+	{
+		return recycling_pool<Depth, IsArray>::instance().allocate(nBytes);
+	}
+
+	static void ops_deallocate(const module_ops*, void* p, size_t nBytes) throw()
+	{
+		recycling_pool<Depth, IsArray>::instance().deallocate(p, nBytes);
+	}
+
+	static const module_ops* fetch() throw()
+	{
+		// blocks are plain heap blocks: deallocating without size bypasses 
+		// recycling; they are rounded to the size classes though, so the 
+		// table is a heap of its own, unequal to allocators of other modes
+		static const module_ops s_ops =
+		{
+			&allocate,
+			fetch_module_ops(IsArray)->deallocate,
+			&s_ops,
+			&ops_allocate,
+			&ops_deallocate,
+			false,
+			fetch_module_ops(IsArray)->hot,
+			fetch_module_ops(IsArray)->cold
+		};
+
+		return &s_ops;
+	}
+};
+
+}	// namespace detail
+
+
+/**	@short	Recycling allocation mode binds allocators to the recycling pool of the current module
+ */
+template<size_t Depth, raw_allocation_type C, typename T>
+struct allocation_mode_traits<recycling_allocation<Depth, C>, T>
+{
+	static const module_ops* fetch_module_ops(bool is_array_allocation) throw()
+	{
+		return is_array_allocation ?
+			detail::recycling_ops<Depth, true>::fetch() :
+			detail::recycling_ops<Depth, false>::fetch();
+	}
+};
+
+
+}	// namespace kj
+
+
+#endif	// file guard
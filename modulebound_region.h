@@ -0,0 +1,258 @@
+/**	@file	Scoped bump regions for the module-bound allocator.
+
+	While a region scope is active on a thread, every module-bound allocator
+	constructed on that thread allocates from the region instead of the heap;
+	deallocation is a no-op and all the region's memory is given back in one
+	step when the scope ends.
+
+	@code
+	void handle(const request& r)
+	{
+		kj::scoped_module_region region;
+
+		std::vector<token, kj::modulebound_allocator<token> > tokens;
+		std::map<key, value, std::less<key>, kj::modulebound_allocator<std::pair<const key, value> > > index;
+		parse(r, tokens, index);
+		respond(tokens, index);
+	}	// tokens and index are destroyed, then the region releases its chunks
+	@endcode
+
+	@date	2026 10 17	kj	created
+ */
+
+#ifndef KJ_MODULEBOUND_REGION_H_INCLUDED
+#define KJ_MODULEBOUND_REGION_H_INCLUDED
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#  pragma once
+#endif
+
+#include <new>	// std::bad_alloc
+#include <cstddef>	// std::max_align_t
+#include <stddef.h>
+#include "modulebound_allocator.h"
+
+
+namespace kj
+{
+
+/**	@short	Function pointer type giving access to a thread's region slot
+ */
+typedef detail::fp_region_slot_t fp_region_slot_t;
+
+
+namespace detail
+{
+
+/**	@short	Bump region whose chunks are allocated by the module that created it.
+
+	The region is its own module_ops table: the table functions receive the
+	table and cast it back to the region.
+	A region is confined to the thread that created it and is not synchronized.
+ */
+class module_region: public module_ops
+{
+	struct chunk
+	{
+		chunk* m_pNext;
+	};
+
+	// blocks are aligned like the heap aligns them
+	static const size_t alignment = alignof(std::max_align_t);
+	static const size_t header_size = (sizeof(chunk) + alignment - 1) & ~(alignment - 1);
+
+	// chunks are allocated by the raw operators of the region's module
+	const module_ops* m_pChunkOps;
+	size_t m_nChunkSize;
+	chunk* m_pChunks;
+	char* m_pCursor;
+	char* m_pEnd;
+
+	// noncopyable
+	module_region(const module_region&);
+	module_region& operator =(const module_region&);
+
+	static void* raw_allocate(size_t)
+	{
+		// a region can't be reached without its table
+		throw std::bad_alloc();
+	}
+
+	static void raw_deallocate(void*) throw()
+	{}
+
+	static void* region_allocate(const module_ops* pOps, size_t nBytes)
+	{
+		return const_cast<module_region*>(static_cast<const module_region*>(pOps))->bump(nBytes);
+	}
+
+	static void region_deallocate(const module_ops*, void*, size_t) throw()
+	{}
+
+	char* add_chunk(size_t nBytes)
+	{
+		chunk* pChunk = static_cast<chunk*>(m_pChunkOps->allocate(header_size + nBytes));
+		if (m_pChunks)
+		{
+			// keep the current chunk in front, it may still have space
+			pChunk->m_pNext = m_pChunks->m_pNext;
+			m_pChunks->m_pNext = pChunk;
+		}
+		else
+		{
+			pChunk->m_pNext = 0;
+			m_pChunks = pChunk;
+		}
+
+		return reinterpret_cast<char*>(pChunk) + header_size;
+	}
+
+public:
+	explicit module_region(size_t nChunkSize) throw():
+		m_pChunkOps(fetch_module_ops(true)),
+		m_nChunkSize(nChunkSize),
+		m_pChunks(0),
+		m_pCursor(0),
+		m_pEnd(0)
+	{
+		allocate = &raw_allocate;
+		deallocate = &raw_deallocate;
+		heap = this;
+		ops_allocate = &region_allocate;
+		ops_deallocate = &region_deallocate;
+		keep_on_copy = true;
+		// a region ignores hints
+		hot = 0;
+		cold = 0;
+	}
+
+	~module_region() throw()
+	{
+		while (chunk* pChunk = m_pChunks)
+		{
+			m_pChunks = pChunk->m_pNext;
+			m_pChunkOps->deallocate(pChunk);
+		}
+	}
+
+	void* bump(size_t nBytes)
+	{
+		nBytes = (nBytes + alignment - 1) & ~(alignment - 1);
+
+		if (size_t(m_pEnd - m_pCursor) >= nBytes)
+		{
+			void* p = m_pCursor;
+			m_pCursor += nBytes;
+			return p;
+		}
+
+		// large blocks get a chunk of their own, leaving the current chunk in use
+		if (nBytes > m_nChunkSize / 4)
+			return add_chunk(nBytes);
+
+		chunk* pCurrent = m_pChunks;
+		m_pChunks = 0;
+		char* pBegin = add_chunk(m_nChunkSize);
+		m_pChunks->m_pNext = pCurrent;
+
+		m_pCursor = pBegin + nBytes;
+		m_pEnd = pBegin + m_nChunkSize;
+		return pBegin;
+	}
+};
+
+}	// namespace detail
+
+
+/**	@short	Makes module-bound allocators constructed on the calling thread
+	allocate from a bump region while the scope is active.
+
+	The region's chunks are allocated by the module constructing the scope
+	and are all released when the scope ends; deallocating a block from the
+	region does nothing.
+	Scopes nest, the innermost scope is active.
+
+	Allocators capture the region when they are default constructed;
+	copies and conversions of an allocator bound to the region stay bound to
+	it, while copies of other allocators capture the current module as usual.
+	Allocators constructed with @c kj::ignore_region ignore the region.
+
+	The library's own long-lived storage ignores an active region: the state
+	of a @c modulebound_object_pool and the storage of the objects it creates
+	(not the allocators the objects' constructors capture), the storage of
+	@c abi_vector and @c basic_abi_string, the retired batches of an
+	@c epoch_domain, and a @c string_intern_pool with its strings. Allocators of allocation modes specializing
+	@c allocation_mode_ignores_region, like @c c_block_allocation, never
+	allocate from a region.
+
+	@attention	Containers bound to the region must not outlive the scope,
+	this also applies to containers rehomed (see modulebound_rehome.h) while
+	the scope is active.
+	A region is not synchronized, containers bound to it must stay on the
+	scope's thread.
+ */
+class scoped_module_region
+{
+	detail::module_region m_region;
+	const module_ops** m_ppSlot;
+	const module_ops* m_pPrevious;
+
+	// noncopyable
+	scoped_module_region(const scoped_module_region&);
+	scoped_module_region& operator =(const scoped_module_region&);
+
+public:
+	/**	@short	Activate a region on the calling thread
+		@param	nChunkSize	number of bytes allocated from the heap at a time
+	 */
+	explicit scoped_module_region(size_t nChunkSize = 64 * 1024) throw():
+		m_region(nChunkSize),
+		m_ppSlot(detail::region_slot_accessor()()),
+		m_pPrevious(*m_ppSlot)
+	{
+		*m_ppSlot = &m_region;
+	}
+
+	/**	@short	Reactivate the enclosing region, if any, and release the chunks
+	 */
+	~scoped_module_region() throw()
+	{
+		*m_ppSlot = m_pPrevious;
+	}
+};
+
+
+/**	@short	The accessor to the region slot used by the current module
+ */
+inline
+fp_region_slot_t get_region_slot() throw()
+{
+	return detail::region_slot_accessor();
+}
+
+/**	@short	Make the current module use another module's region slot, so
+	regions activated in either module apply to both.
+
+	Each module has its own slot where the linker doesn't unify inline
+	function statics between modules (e.g. Windows dlls, or shared objects
+	built with hidden visibility). A plugin links to the host's slot right
+	after loading, before any allocator is constructed:
+	@code
+	// plugin entry point
+	void plugin_init(kj::fp_region_slot_t pfnHostSlot)
+	{
+		kj::link_region_slot(pfnHostSlot);
+	}
+	@endcode
+ */
+inline
+void link_region_slot(fp_region_slot_t pfnSlot) throw()
+{
+	detail::region_slot_accessor() = pfnSlot;
+}
+
+
+}	// namespace kj
+
+
+#endif	// file guard
@@ -0,0 +1,239 @@
+/**	@file	Transfer module-bound storage to another module without copying.
+
+	Before a module gets unloaded, containers it allocated must be bound to
+	a surviving module. If both modules' raw allocation functions are built
+	on the same heap (e.g. both link against the dynamic c runtime), the
+	containers' allocators are simply exchanged in place and no element is
+	touched; otherwise the elements are transferred into storage allocated
+	by the surviving module in one batch.
+
+	@code
+	// host, before unloading the plugin
+	plugin_index_type index = plugin->take_index();
+	kj::rehome(index);
+	unload(plugin);
+	@endcode
+
+	@date	2026 10 17	kj	created
+ */
+
+#ifndef KJ_MODULEBOUND_REHOME_H_INCLUDED
+#define KJ_MODULEBOUND_REHOME_H_INCLUDED
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#  pragma once
+#endif
+
+#include <type_traits>
+#include <iterator>	// std::iterator_traits
+#include <utility>	// std::pair, std::move
+#include "modulebound_allocator.h"
+#include "modulebound_buffer.h"
+#include "modulebound_abi.h"
+
+
+namespace kj
+{
+
+namespace detail
+{
+
+/*	metafunction telling whether T holds module-bound storage
+	(holds_storage), and whether that storage can be rehomed without
+	reconstructing T (in_place), which isn't possible for const objects
+ */
+template<typename T>
+struct rehome_traits
+{
+	static const bool holds_storage = is_modulebound_container<T>::value;
+	static const bool in_place = true;
+};
+
+template<typename T>
+struct rehome_traits<const T>
+{
+	static const bool holds_storage = rehome_traits<T>::holds_storage;
+	static const bool in_place = !holds_storage;
+};
+
+template<typename A, typename B>
+struct rehome_traits<std::pair<A, B> >
+{
+	static const bool holds_storage = rehome_traits<A>::holds_storage || rehome_traits<B>::holds_storage;
+	static const bool in_place = rehome_traits<A>::in_place && rehome_traits<B>::in_place;
+};
+
+template<typename T>
+struct rehome_traits<abi_vector<T> >
+{
+	static const bool holds_storage = true;
+	static const bool in_place = true;
+};
+
+template<typename CharT, typename Traits>
+struct rehome_traits<basic_abi_string<CharT, Traits> >
+{
+	static const bool holds_storage = true;
+	static const bool in_place = true;
+};
+
+// metafunction telling whether the elements of a container can be rehomed in place
+template<typename Container>
+struct rehome_elements_in_place
+{
+	typedef typename Container::value_type value_type;
+	typedef typename std::iterator_traits<typename Container::iterator>::reference reference;
+
+	static const bool value =
+		rehome_traits<value_type>::in_place &&
+		// e.g. set elements are accessible as const only
+		(!rehome_traits<value_type>::holds_storage || !std::is_const<typename std::remove_reference<reference>::type>::value);
+};
+
+}	// namespace detail
+
+
+template<typename Container>
+typename std::enable_if<detail::is_modulebound_container<Container>::value>::type
+rehome(Container& rContainer);
+template<typename T>
+void rehome(abi_vector<T>& rVector);
+template<typename CharT, typename Traits>
+void rehome(basic_abi_string<CharT, Traits>& rString);
+template<typename T>
+void rehome(module_buffer<T>& rBuffer);
+
+
+namespace detail
+{
+
+template<typename T> inline
+void rehome_element(T& /*rElement*/, std::false_type /*holds_storage*/)
+{}
+
+template<typename T> inline
+void rehome_element(T& rElement, std::true_type /*holds_storage*/)
+{
+	kj::rehome(rElement);
+}
+
+template<typename A, typename B> inline
+void rehome_element(std::pair<A, B>& rElement, std::true_type /*holds_storage*/)
+{
+	rehome_element(rElement.first, std::integral_constant<bool, rehome_traits<A>::holds_storage>());
+	rehome_element(rElement.second, std::integral_constant<bool, rehome_traits<B>::holds_storage>());
+}
+
+template<typename Iterator> inline
+void rehome_elements(Iterator first, Iterator last)
+{
+	typedef typename std::iterator_traits<Iterator>::value_type value_type;
+
+	if (!rehome_traits<value_type>::holds_storage)
+		return;
+	for (; first != last; ++first)
+		rehome_element(*first, std::integral_constant<bool, rehome_traits<value_type>::holds_storage>());
+}
+
+// exchange the allocator (same heap) or move the elements (different heaps),
+// then rehome the storage held by the elements
+template<typename Container> inline
+void rehome_container(Container& rContainer, const typename Container::allocator_type& rTarget, std::true_type /*in place*/)
+{
+	Container rehomed(std::move(rContainer), rTarget);
+	rContainer = std::move(rehomed);
+	rehome_elements(rContainer.begin(), rContainer.end());
+}
+
+// elements holding module-bound storage can't be rehomed in place,
+// copying them captures the current module
+template<typename Container> inline
+void rehome_container(Container& rContainer, const typename Container::allocator_type& rTarget, std::false_type /*in place*/)
+{
+	Container rehomed(rContainer, rTarget);
+	rContainer = std::move(rehomed);
+}
+
+template<typename T> inline
+void rehome_container(abi_vector<T>& rVector, std::true_type /*in place*/)
+{
+	rVector.rehome(fetch_module_ops(true));
+	rehome_elements(rVector.begin(), rVector.end());
+}
+
+template<typename T> inline
+void rehome_container(abi_vector<T>& rVector, std::false_type /*in place*/)
+{
+	abi_vector<T> rehomed(rVector.begin(), rVector.end());
+	rVector.swap(rehomed);
+}
+
+}	// namespace detail
+
+
+/**	@short	Bind a container using the module-bound allocator, and all
+	module-bound containers nested in its elements, to the current module.
+
+	If the raw allocation functions of the current module and of the
+	container's module are built on the same heap, the allocator is
+	exchanged in O(1); otherwise the elements are moved into storage
+	allocated by the current module.
+	Elements holding module-bound storage that are only accessible as const
+	(e.g. keys of a map) are copied instead.
+
+	@attention	Call from the surviving module, the module-bound allocator
+	captures the raw allocation functions of the calling module.
+	@throw	@c std::bad_alloc, or any exception thrown by the elements' constructors
+ */
+template<typename Container> inline
+typename std::enable_if<detail::is_modulebound_container<Container>::value>::type
+rehome(Container& rContainer)
+{
+	const typename Container::allocator_type target;
+	detail::rehome_container(rContainer, target, std::integral_constant<bool, detail::rehome_elements_in_place<Container>::value>());
+}
+
+/**	@short	Bind an abi_vector, and all module-bound storage held by its
+	elements, to the current module.
+	@see	rehome(Container&)
+ */
+template<typename T> inline
+void rehome(abi_vector<T>& rVector)
+{
+	detail::rehome_container(rVector, std::integral_constant<bool, detail::rehome_traits<T>::in_place>());
+}
+
+/**	@short	Bind an abi_string to the current module.
+	@see	rehome(Container&)
+ */
+template<typename CharT, typename Traits> inline
+void rehome(basic_abi_string<CharT, Traits>& rString)
+{
+	rString.rehome(detail::fetch_module_ops(true));
+}
+
+/**	@short	Bind a module_buffer, and all module-bound storage held by its
+	elements, to the current module.
+	@see	rehome(Container&)
+ */
+template<typename T> inline
+void rehome(module_buffer<T>& rBuffer)
+{
+	typename module_buffer<T>::vector_type storage(rBuffer.release());
+	try
+	{
+		rehome(storage);
+	}
+	catch (...)
+	{
+		rBuffer = std::move(storage);
+		throw;
+	}
+	rBuffer = std::move(storage);
+}
+
+
+}	// namespace kj
+
+
+#endif	// file guard
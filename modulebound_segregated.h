@@ -0,0 +1,305 @@
+/**	@file	Type-segregated slab heaps for the module-bound allocator.
+
+	With the segregated allocation mode every type an allocator is rebound
+	to gets its own slab heap in the allocating module, so e.g. the nodes of
+	all maps of one type sit next to each other instead of being interleaved
+	with unrelated strings.
+
+	@code
+	typedef kj::modulebound_allocator<std::pair<const key, value>, kj::segregated_allocation<> > node_allocator;
+	typedef std::map<key, value, std::less<key>, node_allocator> index_type;
+	@endcode
+
+	@date	2026 10 17	kj	created
+ */
+
+#ifndef KJ_MODULEBOUND_SEGREGATED_H_INCLUDED
+#define KJ_MODULEBOUND_SEGREGATED_H_INCLUDED
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#  pragma once
+#endif
+
+#include <type_traits>
+#include <mutex>
+#include <new>
+#include <cstddef>	// std::max_align_t
+#include <stddef.h>
+#include "modulebound_allocator.h"
+#include "modulebound_lifecycle.h"
+
+
+namespace kj
+{
+
+/**	@short	Allocation mode placing single objects of each type in a slab heap
+	of their own in the allocating module.
+
+	Only allocations of exactly one object come from the slabs; arrays (e.g.
+	the storage of a vector or the buckets of a hash table) and types larger
+	than an eighth of a slab are allocated by the module's raw operators.
+	Freed blocks are kept on the type's free list; the slabs are given back
+	when the module exits, or later, once the last block is freed.
+
+	The allocation mode is passed as the @c RawAllocation parameter and is
+	preserved when rebinding; @c C chooses the array or single object
+	operators used to get slabs and arrays from the heap.
+
+	@attention	As with the other allocation modes, a copy of an allocator
+	captures the table of the module making the copy; containers are bound
+	to the slab heaps of the module that constructed them.
+ */
+template<raw_allocation_type C = raw_allocation_single>
+struct segregated_allocation: std::integral_constant<raw_allocation_type, C>
+{};
+
+
+namespace detail
+{
+
+// size of a slab, the unit the segregated heaps get from the module's heap
+const size_t segregated_slab_size = 64 * 1024;
+
+// identifies the segregated heaps of the current module
+inline
+const void* segregated_heap_id() throw()
+{
+	static const char s_id = 0;
+	return &s_id;
+}
+
+
+/**	@short	Per-module slab heap for objects of type @c T.
+
+	Blocks are handed out from the free list or carved off the current slab
+	under a lock. The heap is never destroyed, so blocks freed during static
+	destruction find it intact.
+ */
+template<typename T, bool IsArray>
+class segregated_heap
+{
+	struct slab
+	{
+		slab* m_pNext;
+	};
+
+	struct free_block
+	{
+		free_block* m_pNext;
+	};
+
+	static const size_t alignment = alignof(T) > alignof(free_block) ? alignof(T) : alignof(free_block);
+	static const size_t header_size = (sizeof(slab) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+
+public:
+	static const size_t block_size = ((sizeof(T) > sizeof(free_block) ? sizeof(T) : sizeof(free_block)) + alignment - 1) & ~(alignment - 1);
+	///	whether objects of type @c T are allocated from slabs
+	static const bool enabled = alignof(T) <= alignof(std::max_align_t) && block_size <= (segregated_slab_size - header_size) / 8;
+
+private:
+	std::mutex m_mutex;
+	free_block* m_pFree;
+	char* m_pCursor;
+	char* m_pEnd;
+	slab* m_pSlabs;
+	size_t m_nLive;
+	bool m_bClosed;
+
+	segregated_heap() throw():
+		m_pFree(0),
+		m_pCursor(0),
+		m_pEnd(0),
+		m_pSlabs(0),
+		m_nLive(0),
+		m_bClosed(false)
+	{}
+
+	struct closer
+	{
+		segregated_heap& m_rHeap;
+
+		explicit closer(segregated_heap& rHeap) throw():
+			m_rHeap(rHeap)
+		{}
+
+		~closer() throw()
+		{
+			m_rHeap.close();
+		}
+	};
+
+	// give the slabs back, requires the lock
+	void free_slabs() throw()
+	{
+		while (slab* pSlab = m_pSlabs)
+		{
+			m_pSlabs = pSlab->m_pNext;
+			fetch_module_ops(IsArray)->deallocate(pSlab);
+		}
+		m_pFree = 0;
+		m_pCursor = m_pEnd = 0;
+	}
+
+public:
+	///	The heap of the current module
+	static segregated_heap& instance()
+	{
+		static typename std::aligned_storage<sizeof(segregated_heap), alignof(segregated_heap)>::type s_storage;
+		static segregated_heap* s_pHeap = ::new (static_cast<void*>(&s_storage)) segregated_heap();
+		static closer s_closer(*s_pHeap);
+		register_module_cache<&flush, &statistics>();
+		register_fork_handlers<&lock_heap, &unlock_heap, &unlock_heap>();
+		return *s_pHeap;
+	}
+
+	///	Add the current module's heap to @e rStats
+	static void statistics(module_cache_statistics& rStats)
+	{
+		segregated_heap& rHeap = instance();
+		std::lock_guard<std::mutex> lock(rHeap.m_mutex);
+		for (slab* pSlab = rHeap.m_pSlabs; pSlab; pSlab = pSlab->m_pNext)
+			rStats.m_nReservedBytes += segregated_slab_size;
+		rStats.m_nUsedBytes += rHeap.m_nLive * block_size;
+		for (free_block* pBlock = rHeap.m_pFree; pBlock; pBlock = pBlock->m_pNext)
+			rStats.m_nFreeBytes += block_size;
+	}
+
+	static void lock_heap()
+	{
+		instance().m_mutex.lock();
+	}
+
+	static void unlock_heap()
+	{
+		instance().m_mutex.unlock();
+	}
+
+	///	Give the slabs of the current module's heap back if no block is in use
+	static void flush()
+	{
+		segregated_heap& rHeap = instance();
+		std::lock_guard<std::mutex> lock(rHeap.m_mutex);
+		if (!rHeap.m_nLive)
+			rHeap.free_slabs();
+	}
+
+	/**	@short	Allocate a block for one @c T
+		@throw	@c std::bad_alloc
+	 */
+	void* allocate()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		void* p;
+		if (m_pFree)
+		{
+			p = m_pFree;
+			m_pFree = m_pFree->m_pNext;
+		}
+		else
+		{
+			if (size_t(m_pEnd - m_pCursor) < block_size)
+			{
+				slab* pSlab = static_cast<slab*>(fetch_module_ops(IsArray)->allocate(segregated_slab_size));
+				pSlab->m_pNext = m_pSlabs;
+				m_pSlabs = pSlab;
+				m_pCursor = reinterpret_cast<char*>(pSlab) + header_size;
+				m_pEnd = reinterpret_cast<char*>(pSlab) + segregated_slab_size;
+			}
+
+			p = m_pCursor;
+			m_pCursor += block_size;
+		}
+
+		++m_nLive;
+		return p;
+	}
+
+	void deallocate(void* p) throw()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		free_block* pBlock = static_cast<free_block*>(p);
+		pBlock->m_pNext = m_pFree;
+		m_pFree = pBlock;
+
+		if (!--m_nLive && m_bClosed)
+			free_slabs();
+	}
+
+	///	Give the slabs back now or once the last block is freed
+	void close() throw()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bClosed = true;
+		if (!m_nLive)
+			free_slabs();
+	}
+};
+
+
+// memory operations of the segregated allocation mode
+template<typename T, bool IsArray>
+struct segregated_ops
+{
+	typedef segregated_heap<T, IsArray> heap_type;
+
+	static void* ops_allocate(const module_ops*, size_t nBytes)
+	{
+		if (heap_type::enabled && nBytes == sizeof(T))
+			return heap_type::instance().allocate();
+		return fetch_module_ops(IsArray)->allocate(nBytes);
+	}
+
+	static void ops_deallocate(const module_ops*, void* p, size_t nBytes) throw()
+	{
+		if (heap_type::enabled && nBytes == sizeof(T))
+		{
+			if (p)
+				heap_type::instance().deallocate(p);
+		}
+		else
+			fetch_module_ops(IsArray)->deallocate(p);
+	}
+
+	static const module_ops* fetch() throw()
+	{
+		// the raw functions don't know the block size and bypass the slabs
+		static const module_ops s_ops =
+		{
+			fetch_module_ops(IsArray)->allocate,
+			fetch_module_ops(IsArray)->deallocate,
+			segregated_heap_id(),
+			&ops_allocate,
+			&ops_deallocate,
+			false,
+			fetch_module_ops(IsArray)->hot,
+			fetch_module_ops(IsArray)->cold
+		};
+
+		return &s_ops;
+	}
+};
+
+}	// namespace detail
+
+
+/**	@short	Segregated allocation mode binds allocators to the slab heap for
+	@c T of the current module
+ */
+template<raw_allocation_type C, typename T>
+struct allocation_mode_traits<segregated_allocation<C>, T>
+{
+	static const module_ops* fetch_module_ops(bool is_array_allocation) throw()
+	{
+		return is_array_allocation ?
+			detail::segregated_ops<T, true>::fetch() :
+			detail::segregated_ops<T, false>::fetch();
+	}
+};
+
+
+}	// namespace kj
+
+
+#endif	// file guard
@@ -0,0 +1,275 @@
+/**	@file	Unsynchronized pool allocation mode for thread-confined modules.
+
+	A module whose allocations all happen on one thread doesn't need the
+	heap's synchronization; the unsynchronized pool serves small blocks from
+	size-class free lists of the module without any lock or atomic
+	read-modify-write operation.
+
+	@code
+	// plugin running on its own thread only
+	typedef kj::modulebound_allocator<node, kj::unsynchronized_pool_allocation<> > node_allocator;
+	@endcode
+
+	@date	2026 10 17	kj	created
+ */
+
+#ifndef KJ_MODULEBOUND_UNSYNCHRONIZED_H_INCLUDED
+#define KJ_MODULEBOUND_UNSYNCHRONIZED_H_INCLUDED
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#  pragma once
+#endif
+
+#include <type_traits>
+#include <thread>	// std::thread::id
+#include <new>
+#include <cassert>
+#include <stddef.h>
+#include "modulebound_allocator.h"
+#include "modulebound_pool.h"
+#include "modulebound_lifecycle.h"
+
+
+namespace kj
+{
+
+/**	@short	Allocation mode serving blocks up to 1 KiB from an unsynchronized
+	pool of the allocating module, like @c std::pmr::unsynchronized_pool_resource.
+
+	Larger blocks are allocated by the module's raw operators.
+
+	The allocation mode is passed as the @c RawAllocation parameter and is
+	preserved when rebinding; @c C chooses the array or single object
+	operators used to get chunks and large blocks from the heap.
+
+	@attention	All allocators of the mode in a module share one pool, so the
+	module must allocate and free through them on one thread only, including
+	containers handed to other modules. Debug builds (without @c NDEBUG)
+	assert that every call comes from the thread that used the pool first.
+ */
+template<raw_allocation_type C = raw_allocation_single>
+struct unsynchronized_pool_allocation: std::integral_constant<raw_allocation_type, C>
+{};
+
+
+namespace detail
+{
+
+/**	@short	Lock policy of pools confined to one thread: doesn't synchronize;
+	in debug builds asserts that the pool is used by its owner thread,
+	the first thread using it.
+ */
+class owner_thread_check
+{
+#ifndef NDEBUG
+	std::thread::id m_owner;
+#endif
+
+public:
+	void lock()
+	{
+#ifndef NDEBUG
+		const std::thread::id current = std::this_thread::get_id();
+		if (m_owner == std::thread::id())
+			m_owner = current;
+		assert(m_owner == current && "unsynchronized pool used by more than one thread");
+#endif
+	}
+
+	void unlock() throw()
+	{}
+
+	///	Let the next thread using the pool become its owner
+	void release_ownership() throw()
+	{
+#ifndef NDEBUG
+		m_owner = std::thread::id();
+#endif
+	}
+};
+
+
+// memory operations of the unsynchronized pool allocation mode; 
+// the pool is never destroyed, so blocks freed during static destruction 
+// find it intact
+template<bool IsArray>
+struct unsynchronized_pool_ops
+{
+	typedef size_class_pool<owner_thread_check> pool_type;
+
+	// closes the pool when the module exits, on whichever thread
+	struct closer
+	{
+		pool_type& m_rPool;
+
+		explicit closer(pool_type& rPool) throw():
+			m_rPool(rPool)
+		{}
+
+		~closer() throw()
+		{
+			m_rPool.get_lock().release_ownership();
+			m_rPool.close();
+		}
+	};
+
+	static pool_type& pool()
+	{
+		static typename std::aligned_storage<sizeof(pool_type), alignof(pool_type)>::type s_storage;
+		static pool_type* s_pPool = ::new (static_cast<void*>(&s_storage)) pool_type(
+			fetch_module_ops(IsArray)->allocate, 
+			fetch_module_ops(IsArray)->deallocate
+		);
+		static closer s_closer(*s_pPool);
+		// confined to its thread, the pool isn't among the module's caches 
+		// flushed and counted on any thread
+		register_fork_handlers<&ignore_fork, &ignore_fork, &release_pool>();
+		return *s_pPool;
+	}
+
+	static void trim()
+	{
+		pool().trim();
+	}
+
+	static module_cache_statistics statistics()
+	{
+		module_cache_statistics stats = {};
+		stats.m_nCaches = 1;
+		pool().add_statistics(stats);
+		return stats;
+	}
+
+	// in the child the forking thread may take over the pool
+	static void release_pool()
+	{
+		pool().get_lock().release_ownership();
+	}
+
+	// blocks of a size known at compile time, the size class is a constant
+	template<size_t nBytes>
+	static void* allocate_fixed()
+	{
+		if (pool_type::serves(nBytes))
+			return pool().allocate_class(pool_class_of<nBytes>::value);
+		return fetch_module_ops(IsArray)->allocate(nBytes);
+	}
+
+	template<size_t nBytes>
+	static void deallocate_fixed(void* p) throw()
+	{
+		if (pool_type::serves(nBytes))
+			pool().deallocate_class(p, pool_class_of<nBytes>::value);
+		else
+			fetch_module_ops(IsArray)->deallocate(p);
+	}
+
+	static void* ops_allocate(const module_ops*, size_t nBytes)
+	{
+		if (pool_type::serves(nBytes))
+			return pool().allocate(nBytes);
+		return fetch_module_ops(IsArray)->allocate(nBytes);
+	}
+
+	static void ops_deallocate(const module_ops*, void* p, size_t nBytes) throw()
+	{
+		if (pool_type::serves(nBytes))
+			pool().deallocate(p, nBytes);
+		else
+			fetch_module_ops(IsArray)->deallocate(p);
+	}
+
+	static const module_ops* fetch() throw()
+	{
+		// the raw functions don't know the block size and bypass the pool
+		static const module_ops s_ops =
+		{
+			fetch_module_ops(IsArray)->allocate,
+			fetch_module_ops(IsArray)->deallocate,
+			&s_ops,
+			&ops_allocate,
+			&ops_deallocate,
+			false,
+			fetch_module_ops(IsArray)->hot,
+			fetch_module_ops(IsArray)->cold
+		};
+
+		return &s_ops;
+	}
+};
+
+}	// namespace detail
+
+
+/**	@short	Blocks of a size known at compile time come directly from the
+	unsynchronized pool of the current module, the size class is a constant
+ */
+template<raw_allocation_type C>
+struct fixed_size_allocation_traits<unsynchronized_pool_allocation<C> >
+{
+	template<bool IsArray, size_t nBytes>
+	static void* allocate(const module_ops* pOps)
+	{
+		typedef detail::unsynchronized_pool_ops<IsArray> ops_type;
+		if (pOps == ops_type::fetch())
+			return ops_type::template allocate_fixed<nBytes>();
+		return pOps->ops_allocate(pOps, nBytes);
+	}
+
+	template<bool IsArray, size_t nBytes>
+	static void deallocate(const module_ops* pOps, void* p) throw()
+	{
+		typedef detail::unsynchronized_pool_ops<IsArray> ops_type;
+		if (pOps == ops_type::fetch())
+			ops_type::template deallocate_fixed<nBytes>(p);
+		else
+			pOps->ops_deallocate(pOps, p, nBytes);
+	}
+};
+
+
+/**	@short	Unsynchronized pool allocation mode binds allocators to the
+	unsynchronized pool of the current module
+ */
+template<raw_allocation_type C, typename T>
+struct allocation_mode_traits<unsynchronized_pool_allocation<C>, T>
+{
+	static const module_ops* fetch_module_ops(bool is_array_allocation) throw()
+	{
+		return is_array_allocation ?
+			detail::unsynchronized_pool_ops<true>::fetch() :
+			detail::unsynchronized_pool_ops<false>::fetch();
+	}
+};
+
+
+/**	@short	Give the free chunks of the current module's pool of
+	@c unsynchronized_pool_allocation<C> back to the heap.
+
+	The unsynchronized pools are confined to their thread, so
+	@c flush_module_caches() leaves them alone; call this function on the
+	thread using the pool instead. At module exit the pools are closed anyway.
+ */
+template<raw_allocation_type C> inline
+void trim_unsynchronized_pool()
+{
+	detail::unsynchronized_pool_ops<C == raw_allocation_array>::trim();
+}
+
+/**	@short	Memory held by the current module's pool of
+	@c unsynchronized_pool_allocation<C>.
+
+	Like @c trim_unsynchronized_pool(), call it on the thread using the pool;
+	@c get_module_cache_statistics() doesn't count the unsynchronized pools.
+ */
+template<raw_allocation_type C> inline
+module_cache_statistics get_unsynchronized_pool_statistics()
+{
+	return detail::unsynchronized_pool_ops<C == raw_allocation_array>::statistics();
+}
+
+
+}	// namespace kj
+
+
+#endif	// file guard
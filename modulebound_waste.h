@@ -0,0 +1,401 @@
+/**	@file	Internal waste and fragmentation statistics of module heaps.
+
+	The waste tracking allocation mode records for every allocation the
+	requested size and the size the heap actually reserved for the block
+	(@c malloc_usable_size, @c _msize), by request size. Together with the
+	memory the caches of the other allocation modes hold, this makes up the
+	module's waste report.
+
+	@code
+	typedef std::basic_string<char, std::char_traits<char>, kj::modulebound_allocator<char[], kj::waste_tracking_allocation<kj::raw_allocation_array> > > tracked_string;
+
+	kj::write_module_waste_report(stderr, kj::get_module_waste_report());
+	@endcode
+
+	If the environment variable @c KJ_MODULEBOUND_WASTE_REPORT names a file,
+	every module using the mode appends its report to it when it exits;
+	@c tools/waste_report.cpp summarizes such files. The module's file name
+	is looked up with @c dladdr (link with @c -ldl before glibc 2.34).
+
+	@date	2026 10 17	kj	created
+ */
+
+#ifndef KJ_MODULEBOUND_WASTE_H_INCLUDED
+#define KJ_MODULEBOUND_WASTE_H_INCLUDED
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#  pragma once
+#endif
+
+#include <type_traits>
+#include <atomic>
+#include <vector>
+#include <new>
+#include <cstdio>
+#include <cstdlib>	// std::getenv
+#include <stddef.h>
+#if defined(_MSC_VER) || defined(__MINGW32__)
+#  include <malloc.h>	// _msize
+#elif defined(__APPLE__)
+#  include <malloc/malloc.h>	// malloc_size
+#  include <dlfcn.h>
+#else
+#  include <malloc.h>	// malloc_usable_size
+#  include <dlfcn.h>
+#endif
+#include "modulebound_allocator.h"
+#include "modulebound_lifecycle.h"
+
+
+namespace kj
+{
+
+/**	@short	Allocation mode recording the requested and the reserved size of
+	every block of the allocating module.
+
+	Blocks come from the module's raw operators, so the reserved size is
+	what the c runtime's heap reserved. With @c KJ_MODULEBOUND_CUSTOM_OPERATOR_NEW
+	the heap is unknown and the reserved size is taken as requested.
+	Allocations with hot/cold hints are served by the hinted pools and are
+	accounted in the module's cache statistics instead.
+
+	The allocation mode is passed as the @c RawAllocation parameter and is
+	preserved when rebinding; @c C chooses the array or single object
+	operators.
+ */
+template<raw_allocation_type C = raw_allocation_single>
+struct waste_tracking_allocation: std::integral_constant<raw_allocation_type, C>
+{};
+
+
+/**	@short	Allocations of one range of request sizes
+ */
+struct waste_bucket
+{
+	///	largest request size of the bucket
+	size_t m_nUpperBound;
+	size_t m_nAllocations;
+	size_t m_nRequestedBytes;
+	size_t m_nUsableBytes;
+};
+
+/**	@short	Waste report of a module.
+
+	Totals count all allocations made so far, live ones those not freed yet.
+ */
+struct module_waste_report
+{
+	size_t m_nAllocations;
+	size_t m_nLiveAllocations;
+	size_t m_nRequestedBytes;
+	size_t m_nLiveRequestedBytes;
+	size_t m_nUsableBytes;
+	size_t m_nLiveUsableBytes;
+	///	buckets with allocations, by ascending request size
+	std::vector<waste_bucket> m_buckets;
+	///	memory held by the caches of the module's allocation modes
+	module_cache_statistics m_caches;
+};
+
+
+namespace detail
+{
+
+// request sizes up to waste_small_limit are counted in steps of
+// waste_small_granularity, larger ones by powers of two
+const size_t waste_small_granularity = 8;
+const size_t waste_small_limit = 1024;
+const size_t waste_small_bucket_count = waste_small_limit / waste_small_granularity;
+const size_t waste_bucket_count = waste_small_bucket_count + sizeof(size_t) * 8;
+
+inline
+size_t waste_bucket_index(size_t nBytes) throw()
+{
+	if (nBytes <= waste_small_limit)
+		return nBytes ? (nBytes - 1) / waste_small_granularity : 0;
+
+	size_t nIndex = waste_small_bucket_count;
+	for (size_t nUpper = waste_small_limit * 2; nUpper && nUpper < nBytes; nUpper <<= 1)
+		++nIndex;
+	return nIndex;
+}
+
+inline
+size_t waste_bucket_upper_bound(size_t nIndex) throw()
+{
+	if (nIndex < waste_small_bucket_count)
+		return (nIndex + 1) * waste_small_granularity;
+
+	size_t nUpper = waste_small_limit;
+	for (size_t i = waste_small_bucket_count; i <= nIndex; ++i)
+	{
+		if (nUpper > ~size_t(0) / 2)
+			return ~size_t(0);
+		nUpper <<= 1;
+	}
+	return nUpper;
+}
+
+// bytes the heap reserved for the block p of nRequested bytes
+inline
+size_t usable_size(void* p, size_t nRequested) throw()
+{
+#if defined(KJ_MODULEBOUND_CUSTOM_OPERATOR_NEW)
+	(void) p;
+	return nRequested;
+#elif defined(_MSC_VER) || defined(__MINGW32__)
+	return p ? _msize(p) : nRequested;
+#elif defined(__APPLE__)
+	return p ? malloc_size(p) : nRequested;
+#else
+	return p ? malloc_usable_size(p) : nRequested;
+#endif
+}
+
+
+/**	@short	Per-module counters of the waste tracking allocation mode.
+
+	The counters are never destroyed, so blocks freed during static
+	destruction find them intact. When the module exits, the report is
+	appended to the file named by @c KJ_MODULEBOUND_WASTE_REPORT.
+ */
+class waste_statistics
+{
+	struct bucket
+	{
+		std::atomic<size_t> m_nAllocations;
+		std::atomic<size_t> m_nRequestedBytes;
+		std::atomic<size_t> m_nUsableBytes;
+	};
+
+	bucket m_buckets[waste_bucket_count];
+	std::atomic<size_t> m_nLiveAllocations;
+	std::atomic<size_t> m_nLiveRequestedBytes;
+	std::atomic<size_t> m_nLiveUsableBytes;
+
+	waste_statistics() throw():
+		m_nLiveAllocations(0),
+		m_nLiveRequestedBytes(0),
+		m_nLiveUsableBytes(0)
+	{
+		for (size_t i = 0; i != waste_bucket_count; ++i)
+		{
+			m_buckets[i].m_nAllocations.store(0, std::memory_order_relaxed);
+			m_buckets[i].m_nRequestedBytes.store(0, std::memory_order_relaxed);
+			m_buckets[i].m_nUsableBytes.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	// noncopyable
+	waste_statistics(const waste_statistics&);
+	waste_statistics& operator =(const waste_statistics&);
+
+	struct closer
+	{
+		waste_statistics& m_rStatistics;
+
+		explicit closer(waste_statistics& rStatistics) throw():
+			m_rStatistics(rStatistics)
+		{}
+
+		~closer();
+	};
+
+public:
+	///	The counters of the current module
+	static waste_statistics& instance()
+	{
+		static std::aligned_storage<sizeof(waste_statistics), alignof(waste_statistics)>::type s_storage;
+		static waste_statistics* s_pStatistics = ::new (static_cast<void*>(&s_storage)) waste_statistics();
+		static closer s_closer(*s_pStatistics);
+		return *s_pStatistics;
+	}
+
+	void on_allocate(size_t nRequested, size_t nUsable) throw()
+	{
+		bucket& rBucket = m_buckets[waste_bucket_index(nRequested)];
+		rBucket.m_nAllocations.fetch_add(1, std::memory_order_relaxed);
+		rBucket.m_nRequestedBytes.fetch_add(nRequested, std::memory_order_relaxed);
+		rBucket.m_nUsableBytes.fetch_add(nUsable, std::memory_order_relaxed);
+		m_nLiveAllocations.fetch_add(1, std::memory_order_relaxed);
+		m_nLiveRequestedBytes.fetch_add(nRequested, std::memory_order_relaxed);
+		m_nLiveUsableBytes.fetch_add(nUsable, std::memory_order_relaxed);
+	}
+
+	void on_deallocate(size_t nRequested, size_t nUsable) throw()
+	{
+		m_nLiveAllocations.fetch_sub(1, std::memory_order_relaxed);
+		m_nLiveRequestedBytes.fetch_sub(nRequested, std::memory_order_relaxed);
+		m_nLiveUsableBytes.fetch_sub(nUsable, std::memory_order_relaxed);
+	}
+
+	///	@throw	@c std::bad_alloc
+	module_waste_report report() const
+	{
+		module_waste_report result = {};
+		for (size_t i = 0; i != waste_bucket_count; ++i)
+		{
+			const waste_bucket entry =
+			{
+				waste_bucket_upper_bound(i),
+				m_buckets[i].m_nAllocations.load(std::memory_order_relaxed),
+				m_buckets[i].m_nRequestedBytes.load(std::memory_order_relaxed),
+				m_buckets[i].m_nUsableBytes.load(std::memory_order_relaxed)
+			};
+			if (!entry.m_nAllocations)
+				continue;
+
+			result.m_buckets.push_back(entry);
+			result.m_nAllocations += entry.m_nAllocations;
+			result.m_nRequestedBytes += entry.m_nRequestedBytes;
+			result.m_nUsableBytes += entry.m_nUsableBytes;
+		}
+		result.m_nLiveAllocations = m_nLiveAllocations.load(std::memory_order_relaxed);
+		result.m_nLiveRequestedBytes = m_nLiveRequestedBytes.load(std::memory_order_relaxed);
+		result.m_nLiveUsableBytes = m_nLiveUsableBytes.load(std::memory_order_relaxed);
+		result.m_caches = get_module_cache_statistics();
+		return result;
+	}
+};
+
+
+// memory operations of the waste tracking allocation mode
+template<bool IsArray>
+struct waste_tracking_ops
+{
+	static void* ops_allocate(const module_ops*, size_t nBytes)
+	{
+		const module_ops* pOps = fetch_module_ops(IsArray);
+		void* p = pOps->ops_allocate(pOps, nBytes);
+		waste_statistics::instance().on_allocate(nBytes, usable_size(p, nBytes));
+		return p;
+	}
+
+	static void ops_deallocate(const module_ops*, void* p, size_t nBytes) throw()
+	{
+		if (p)
+			waste_statistics::instance().on_deallocate(nBytes, usable_size(p, nBytes));
+		const module_ops* pOps = fetch_module_ops(IsArray);
+		pOps->ops_deallocate(pOps, p, nBytes);
+	}
+
+	static const module_ops* fetch() throw()
+	{
+		// the raw functions don't know the block size and bypass the counters
+		static const module_ops s_ops =
+		{
+			fetch_module_ops(IsArray)->allocate,
+			fetch_module_ops(IsArray)->deallocate,
+			&s_ops,
+			&ops_allocate,
+			&ops_deallocate,
+			false,
+			fetch_module_ops(IsArray)->hot,
+			fetch_module_ops(IsArray)->cold
+		};
+
+		return &s_ops;
+	}
+};
+
+// path of the file of the current module, 0 if unknown
+inline
+const char* module_file_name() throw()
+{
+#if defined(_MSC_VER) || defined(__MINGW32__)
+	return 0;
+#else
+	Dl_info info;
+	if (!::dladdr(reinterpret_cast<const void*>(waste_tracking_ops<false>::fetch()), &info))
+		return 0;
+	return info.dli_fname;
+#endif
+}
+
+}	// namespace detail
+
+
+/**	@short	Waste tracking allocation mode binds allocators to the counters
+	of the current module
+ */
+template<raw_allocation_type C, typename T>
+struct allocation_mode_traits<waste_tracking_allocation<C>, T>
+{
+	static const module_ops* fetch_module_ops(bool is_array_allocation) throw()
+	{
+		return is_array_allocation ?
+			detail::waste_tracking_ops<true>::fetch() :
+			detail::waste_tracking_ops<false>::fetch();
+	}
+};
+
+
+/**	@short	Waste report of the current module
+	@throw	@c std::bad_alloc
+ */
+inline
+module_waste_report get_module_waste_report()
+{
+	return detail::waste_statistics::instance().report();
+}
+
+/**	@short	Append @e rReport to @e pFile in the text format read by
+	@c tools/waste_report.cpp (and @c tools/size_class_generator.cpp).
+
+	@param	pszModule	name of the module, 0 for the current module's file
+ */
+inline
+void write_module_waste_report(std::FILE* pFile, const module_waste_report& rReport, const char* pszModule = 0)
+{
+	if (!pszModule)
+		pszModule = detail::module_file_name();
+
+	std::fprintf(pFile, "module %s\n", pszModule ? pszModule : "<unknown>");
+	std::fprintf(pFile, "allocations %zu %zu\n", rReport.m_nAllocations, rReport.m_nLiveAllocations);
+	std::fprintf(pFile, "requested %zu %zu\n", rReport.m_nRequestedBytes, rReport.m_nLiveRequestedBytes);
+	std::fprintf(pFile, "usable %zu %zu\n", rReport.m_nUsableBytes, rReport.m_nLiveUsableBytes);
+	std::fprintf(pFile, "caches %zu %zu %zu %zu\n",
+		rReport.m_caches.m_nCaches, rReport.m_caches.m_nReservedBytes,
+		rReport.m_caches.m_nUsedBytes, rReport.m_caches.m_nFreeBytes
+	);
+	for (size_t i = 0; i != rReport.m_buckets.size(); ++i)
+	{
+		const waste_bucket& rBucket = rReport.m_buckets[i];
+		std::fprintf(pFile, "bucket %zu %zu %zu %zu\n",
+			rBucket.m_nUpperBound, rBucket.m_nAllocations, rBucket.m_nRequestedBytes, rBucket.m_nUsableBytes
+		);
+	}
+	std::fprintf(pFile, "end\n");
+}
+
+
+namespace detail
+{
+
+inline
+waste_statistics::closer::~closer()
+{
+	const char* pszPath = std::getenv("KJ_MODULEBOUND_WASTE_REPORT");
+	if (!pszPath || !*pszPath)
+		return;
+
+	try
+	{
+		const module_waste_report report = m_rStatistics.report();
+		if (std::FILE* pFile = std::fopen(pszPath, "a"))
+		{
+			write_module_waste_report(pFile, report);
+			std::fclose(pFile);
+		}
+	}
+	catch (...)
+	{}
+}
+
+}	// namespace detail
+
+
+}	// namespace kj
+
+
+#endif	// file guard
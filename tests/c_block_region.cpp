@@ -0,0 +1,49 @@
+/**	@file	Blocks of the C block allocation mode allocated while a region is
+	active still carry the header C code reads.
+
+	@code
+	g++ -std=c++11 -fsanitize=address -I.. c_block_region.cpp -o c_block_region
+	./c_block_region
+	@endcode
+
+	@date	2026 10 17	kj	created
+ */
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include "../modulebound_c.h"
+#include "../modulebound_region.h"
+
+
+int main()
+{
+	typedef kj::modulebound_allocator<char, kj::c_block_allocation<> > c_allocator;
+
+	char* p = 0;
+	char* q = 0;
+	{
+		kj::scoped_module_region region;
+
+		c_allocator allocator;
+		assert(allocator.get_module_ops() == kj::detail::c_block_ops::fetch());
+		p = allocator.allocate(16);
+		std::memcpy(p, "region", 7);
+
+		// converted from an allocator bound to the region
+		const kj::modulebound_allocator<char> regionAllocator;
+		const c_allocator converted(regionAllocator);
+		assert(converted.get_module_ops() == kj::detail::c_block_ops::fetch());
+		q = c_allocator(converted).allocate(8);
+	}
+
+	// C code resizes and frees the blocks after the region is gone
+	assert(kj_module_block_size(p) == 16);
+	p = static_cast<char*>(kj_module_realloc(p, 4096));
+	assert(p && !std::strcmp(p, "region"));
+	kj_module_free(p);
+	kj_module_free(q);
+
+	std::puts("ok");
+	return 0;
+}
@@ -0,0 +1,267 @@
+/**	@file	Generates the size class table of the module-bound pools from
+	recorded allocation sizes.
+
+	Reads the request size histograms of waste reports (written by
+	kj::write_module_waste_report(), e.g. collected with
+	@c KJ_MODULEBOUND_WASTE_REPORT) and chooses the block sizes of the pools
+	that waste the least memory on the recorded requests. The result is a
+	header with @c constexpr tables; a module compiled with
+	@c KJ_MODULEBOUND_POOL_SIZE_CLASSES set to its path uses them.
+
+	@code
+	g++ -O2 -std=c++11 -I.. size_class_generator.cpp -o size_class_generator
+	KJ_MODULEBOUND_WASTE_REPORT=/tmp/waste.txt ./plugin_host
+	./size_class_generator -c 12 -m libplugin.so -o plugin_size_classes.h /tmp/waste.txt
+	g++ ... -DKJ_MODULEBOUND_POOL_SIZE_CLASSES='"plugin_size_classes.h"' plugin.cpp
+	@endcode
+
+	Options:
+	- @c -c @e count: number of size classes, default 16
+	- @c -m @e module: only use the reports of modules whose path contains
+	  @e module
+	- @c -o @e file: write the header to @e file instead of stdout
+
+	@date	2026 10 17	kj	created
+ */
+
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdlib>	// std::atoi
+#include <cstring>	// std::strcmp, std::strstr
+#include <stddef.h>
+#include "../modulebound_pool.h"
+
+
+namespace
+{
+
+using kj::detail::pool_granularity;
+using kj::detail::pool_max_block_size;
+
+const size_t granule_count = pool_max_block_size / pool_granularity;
+
+
+// recorded requests served by blocks of a number of granules
+struct granule_load
+{
+	double m_dAllocations;
+	double m_dRequestedBytes;
+};
+
+
+bool read_histogram(std::FILE* pFile, const char* pszModule, std::vector<granule_load>& rLoads)
+{
+	char line[4096];
+	bool bSelected = false;
+	while (std::fgets(line, sizeof(line), pFile))
+	{
+		char name[4096];
+		size_t nUpper, nAllocations, nRequested, nUsable;
+		if (std::sscanf(line, "module %4095[^\n]", name) == 1)
+			bSelected = !pszModule || std::strstr(name, pszModule);
+		else if (bSelected && std::sscanf(line, "bucket %zu %zu %zu %zu", &nUpper, &nAllocations, &nRequested, &nUsable) == 4)
+		{
+			// larger requests aren't served by the pools
+			if (nUpper > pool_max_block_size)
+				continue;
+			// the bucket's requests may be as large as its upper bound
+			granule_load& rLoad = rLoads[(nUpper + pool_granularity - 1) / pool_granularity];
+			rLoad.m_dAllocations += double(nAllocations);
+			rLoad.m_dRequestedBytes += double(nRequested);
+		}
+	}
+	return !std::ferror(pFile);
+}
+
+// bytes wasted when blocks of nLast granules serve the requests of granules (nFirst, nLast]
+double waste(const std::vector<granule_load>& rLoads, size_t nFirst, size_t nLast)
+{
+	double dWaste = 0;
+	for (size_t g = nFirst + 1; g <= nLast; ++g)
+		dWaste += rLoads[g].m_dAllocations * double(nLast * pool_granularity) - rLoads[g].m_dRequestedBytes;
+	return dWaste;
+}
+
+// the nClasses block sizes (in granules, ascending, the last one granule_count)
+// with the least waste; dynamic programming over the class boundaries
+std::vector<size_t> choose_classes(const std::vector<granule_load>& rLoads, size_t nClasses, double& rdWaste)
+{
+	const double dNone = -1;
+	// best[k][g]: least waste serving granules 1..g with k classes, the largest g
+	std::vector<std::vector<double> > best(nClasses + 1, std::vector<double>(granule_count + 1, dNone));
+	std::vector<std::vector<size_t> > previous(nClasses + 1, std::vector<size_t>(granule_count + 1, 0));
+	best[0][0] = 0;
+
+	for (size_t k = 1; k <= nClasses; ++k)
+		for (size_t g = 1; g <= granule_count; ++g)
+			for (size_t a = 0; a < g; ++a)
+			{
+				if (best[k - 1][a] == dNone)
+					continue;
+				const double dWaste = best[k - 1][a] + waste(rLoads, a, g);
+				if (best[k][g] == dNone || dWaste < best[k][g])
+				{
+					best[k][g] = dWaste;
+					previous[k][g] = a;
+				}
+			}
+
+	// fewer classes if there are fewer granules
+	size_t k = nClasses;
+	while (best[k][granule_count] == dNone)
+		--k;
+	rdWaste = best[k][granule_count];
+
+	std::vector<size_t> classes(k);
+	for (size_t g = granule_count; k; g = previous[k][g], --k)
+		classes[k - 1] = g;
+	return classes;
+}
+
+void write_header(std::FILE* pFile, const std::vector<size_t>& rClasses, double dRequested, double dWaste, double dUniformWaste)
+{
+	std::fprintf(pFile,
+		"/**\t@file\tSize classes of the module-bound pools.\n"
+		"\n"
+		"\tGenerated by tools/size_class_generator.cpp from recorded allocations;\n"
+		"\tinternal waste of the recorded pool requests %.1f%% (uniform classes %.1f%%).\n"
+		"\tUse it by compiling a module with\n"
+		"\t-DKJ_MODULEBOUND_POOL_SIZE_CLASSES='\"<path of this header>\"'.\n"
+		" */\n"
+		"\n"
+		"#ifndef KJ_MODULEBOUND_GENERATED_SIZE_CLASSES_H_INCLUDED\n"
+		"#define KJ_MODULEBOUND_GENERATED_SIZE_CLASSES_H_INCLUDED\n"
+		"\n"
+		"#include <stddef.h>\n"
+		"\n"
+		"\n"
+		"namespace kj\n"
+		"{\n"
+		"\n"
+		"namespace detail\n"
+		"{\n"
+		"\n"
+		"template<typename Dummy>\n"
+		"struct generated_size_classes_table\n"
+		"{\n"
+		"\tstatic const size_t granularity = %zu;\n"
+		"\tstatic const size_t count = %zu;\n"
+		"\t// block size of each class\n"
+		"\tstatic constexpr unsigned short sizes[%zu] = {",
+		dRequested ? 100.0 * dWaste / (dRequested + dWaste) : 0.0,
+		dRequested ? 100.0 * dUniformWaste / (dRequested + dUniformWaste) : 0.0,
+		pool_granularity, rClasses.size(), rClasses.size()
+	);
+	for (size_t i = 0; i != rClasses.size(); ++i)
+		std::fprintf(pFile, "%s%zu", i ? ", " : " ", rClasses[i] * pool_granularity);
+	std::fprintf(pFile, " };\n"
+		"\t// class of each number of granules, minus one\n"
+		"\tstatic constexpr unsigned char granule_classes[%zu] = {", granule_count
+	);
+	for (size_t g = 1, nClass = 0; g <= granule_count; ++g)
+	{
+		while (rClasses[nClass] < g)
+			++nClass;
+		std::fprintf(pFile, "%s%s%zu", g == 1 ? "" : ",", (g - 1) % 16 ? " " : "\n\t\t", nClass);
+	}
+	std::fprintf(pFile, "\n\t};\n"
+		"\n"
+		"\tstatic constexpr size_t index(size_t nBytes)\n"
+		"\t{\n"
+		"\t\treturn granule_classes[nBytes ? (nBytes - 1) / granularity : 0];\n"
+		"\t}\n"
+		"\n"
+		"\tstatic constexpr size_t size(size_t nIndex)\n"
+		"\t{\n"
+		"\t\treturn sizes[nIndex];\n"
+		"\t}\n"
+		"};\n"
+		"\n"
+		"template<typename Dummy>\n"
+		"constexpr unsigned short generated_size_classes_table<Dummy>::sizes[];\n"
+		"template<typename Dummy>\n"
+		"constexpr unsigned char generated_size_classes_table<Dummy>::granule_classes[];\n"
+		"\n"
+		"typedef generated_size_classes_table<void> generated_size_classes;\n"
+		"\n"
+		"}\t// namespace detail\n"
+		"\n"
+		"}\t// namespace kj\n"
+		"\n"
+		"\n"
+		"#endif\t// file guard\n"
+	);
+}
+
+}	// namespace
+
+
+int main(int argc, char* argv[])
+{
+	size_t nClasses = 16;
+	const char* pszModule = 0;
+	const char* pszOutput = 0;
+	std::vector<const char*> inputs;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (!std::strcmp(argv[i], "-c") && i + 1 < argc)
+			nClasses = size_t(std::atoi(argv[++i]));
+		else if (!std::strcmp(argv[i], "-m") && i + 1 < argc)
+			pszModule = argv[++i];
+		else if (!std::strcmp(argv[i], "-o") && i + 1 < argc)
+			pszOutput = argv[++i];
+		else
+			inputs.push_back(argv[i]);
+	}
+	if (nClasses < 1 || nClasses > granule_count)
+	{
+		std::fprintf(stderr, "size_class_generator: the number of classes must be 1 to %zu\n", granule_count);
+		return 1;
+	}
+
+	std::vector<granule_load> loads(granule_count + 1);
+	if (inputs.empty())
+		read_histogram(stdin, pszModule, loads);
+	for (size_t i = 0; i != inputs.size(); ++i)
+	{
+		std::FILE* pFile = std::fopen(inputs[i], "r");
+		if (!pFile || !read_histogram(pFile, pszModule, loads))
+		{
+			std::fprintf(stderr, "size_class_generator: can't read %s\n", inputs[i]);
+			if (pFile)
+				std::fclose(pFile);
+			return 1;
+		}
+		std::fclose(pFile);
+	}
+
+	double dRequested = 0, dUniformWaste = 0;
+	for (size_t g = 1; g <= granule_count; ++g)
+	{
+		dRequested += loads[g].m_dRequestedBytes;
+		dUniformWaste += waste(loads, g - 1, g);
+	}
+	if (!dRequested)
+		std::fprintf(stderr, "size_class_generator: no pool-sized requests recorded, classes are spread evenly\n");
+
+	double dWaste = 0;
+	std::vector<size_t> classes;
+	if (dRequested)
+		classes = choose_classes(loads, nClasses, dWaste);
+	else
+		for (size_t i = 1; i <= nClasses; ++i)
+			classes.push_back(granule_count * i / nClasses);
+
+	std::FILE* pFile = pszOutput ? std::fopen(pszOutput, "w") : stdout;
+	if (!pFile)
+	{
+		std::fprintf(stderr, "size_class_generator: can't write %s\n", pszOutput);
+		return 1;
+	}
+	write_header(pFile, classes, dRequested, dWaste, dUniformWaste);
+	if (pszOutput)
+		std::fclose(pFile);
+
+	return 0;
+}
@@ -0,0 +1,171 @@
+/**	@file	Summarizes the waste reports of module heaps.
+
+	Reads reports written by kj::write_module_waste_report() (e.g. collected
+	with @c KJ_MODULEBOUND_WASTE_REPORT) and prints per module the internal
+	waste of the tracked allocations, the fragmentation of the allocation
+	modes' caches and the request sizes wasting the most memory. Reports of
+	the same module (e.g. of several runs) are added up.
+
+	@code
+	g++ -O2 -std=c++11 -I.. waste_report.cpp -o waste_report
+	KJ_MODULEBOUND_WASTE_REPORT=/tmp/waste.txt ./host
+	./waste_report /tmp/waste.txt
+	@endcode
+
+	@date	2026 10 17	kj	created
+ */
+
+#include <map>
+#include <vector>
+#include <string>
+#include <algorithm>	// std::sort
+#include <cstdio>
+#include <cstring>	// std::strcmp
+#include <stddef.h>
+#include "../modulebound_waste.h"
+
+
+namespace
+{
+
+// buckets listed per module
+const size_t top_buckets = 5;
+
+
+struct module_summary
+{
+	size_t m_nReports;
+	kj::module_waste_report m_report;
+	// by upper bound
+	std::map<size_t, kj::waste_bucket> m_buckets;
+};
+
+typedef std::map<std::string, module_summary> summary_map;
+
+
+bool more_waste(const kj::waste_bucket& rLeft, const kj::waste_bucket& rRight)
+{
+	return rLeft.m_nUsableBytes - rLeft.m_nRequestedBytes > rRight.m_nUsableBytes - rRight.m_nRequestedBytes;
+}
+
+double percent(size_t nPart, size_t nWhole)
+{
+	return nWhole ? 100.0 * double(nPart) / double(nWhole) : 0.0;
+}
+
+
+bool read_reports(std::FILE* pFile, summary_map& rSummaries)
+{
+	char line[4096];
+	module_summary* pSummary = 0;
+	while (std::fgets(line, sizeof(line), pFile))
+	{
+		char name[4096];
+		size_t n[4];
+		if (std::sscanf(line, "module %4095[^\n]", name) == 1)
+		{
+			pSummary = &rSummaries[name];
+			++pSummary->m_nReports;
+		}
+		else if (!pSummary)
+			continue;
+		else if (std::sscanf(line, "allocations %zu %zu", &n[0], &n[1]) == 2)
+		{
+			pSummary->m_report.m_nAllocations += n[0];
+			pSummary->m_report.m_nLiveAllocations += n[1];
+		}
+		else if (std::sscanf(line, "requested %zu %zu", &n[0], &n[1]) == 2)
+		{
+			pSummary->m_report.m_nRequestedBytes += n[0];
+			pSummary->m_report.m_nLiveRequestedBytes += n[1];
+		}
+		else if (std::sscanf(line, "usable %zu %zu", &n[0], &n[1]) == 2)
+		{
+			pSummary->m_report.m_nUsableBytes += n[0];
+			pSummary->m_report.m_nLiveUsableBytes += n[1];
+		}
+		else if (std::sscanf(line, "caches %zu %zu %zu %zu", &n[0], &n[1], &n[2], &n[3]) == 4)
+		{
+			pSummary->m_report.m_caches.m_nCaches += n[0];
+			pSummary->m_report.m_caches.m_nReservedBytes += n[1];
+			pSummary->m_report.m_caches.m_nUsedBytes += n[2];
+			pSummary->m_report.m_caches.m_nFreeBytes += n[3];
+		}
+		else if (std::sscanf(line, "bucket %zu %zu %zu %zu", &n[0], &n[1], &n[2], &n[3]) == 4)
+		{
+			kj::waste_bucket& rBucket = pSummary->m_buckets[n[0]];
+			rBucket.m_nUpperBound = n[0];
+			rBucket.m_nAllocations += n[1];
+			rBucket.m_nRequestedBytes += n[2];
+			rBucket.m_nUsableBytes += n[3];
+		}
+		else if (!std::strcmp(line, "end\n"))
+			pSummary = 0;
+	}
+	return !std::ferror(pFile);
+}
+
+void print_summary(const std::string& rModule, const module_summary& rSummary)
+{
+	const kj::module_waste_report& rReport = rSummary.m_report;
+	const kj::module_cache_statistics& rCaches = rReport.m_caches;
+
+	std::printf("%s (%zu reports)\n", rModule.c_str(), rSummary.m_nReports);
+	std::printf("  tracked allocations %zu, requested %zu bytes, reserved %zu bytes, internal waste %.1f%%\n",
+		rReport.m_nAllocations, rReport.m_nRequestedBytes, rReport.m_nUsableBytes,
+		percent(rReport.m_nUsableBytes - rReport.m_nRequestedBytes, rReport.m_nUsableBytes)
+	);
+	std::printf("  live at exit %zu, requested %zu bytes, reserved %zu bytes\n",
+		rReport.m_nLiveAllocations, rReport.m_nLiveRequestedBytes, rReport.m_nLiveUsableBytes
+	);
+	std::printf("  caches %zu, reserved %zu bytes, in use %zu bytes, free %zu bytes, external fragmentation %.1f%%\n",
+		rCaches.m_nCaches, rCaches.m_nReservedBytes, rCaches.m_nUsedBytes, rCaches.m_nFreeBytes,
+		percent(rCaches.m_nFreeBytes, rCaches.m_nUsedBytes + rCaches.m_nFreeBytes)
+	);
+
+	std::vector<kj::waste_bucket> buckets;
+	for (std::map<size_t, kj::waste_bucket>::const_iterator it = rSummary.m_buckets.begin(); it != rSummary.m_buckets.end(); ++it)
+		buckets.push_back(it->second);
+	std::sort(buckets.begin(), buckets.end(), &more_waste);
+	if (buckets.size() > top_buckets)
+		buckets.resize(top_buckets);
+
+	for (size_t i = 0; i != buckets.size(); ++i)
+	{
+		const kj::waste_bucket& rBucket = buckets[i];
+		if (rBucket.m_nUsableBytes == rBucket.m_nRequestedBytes)
+			break;
+		std::printf("  requests up to %zu bytes: %zu allocations, %zu bytes wasted (%.1f%%)\n",
+			rBucket.m_nUpperBound, rBucket.m_nAllocations, rBucket.m_nUsableBytes - rBucket.m_nRequestedBytes,
+			percent(rBucket.m_nUsableBytes - rBucket.m_nRequestedBytes, rBucket.m_nUsableBytes)
+		);
+	}
+}
+
+}	// namespace
+
+
+int main(int argc, char* argv[])
+{
+	summary_map summaries;
+
+	if (argc < 2)
+		read_reports(stdin, summaries);
+	for (int i = 1; i < argc; ++i)
+	{
+		std::FILE* pFile = std::fopen(argv[i], "r");
+		if (!pFile || !read_reports(pFile, summaries))
+		{
+			std::fprintf(stderr, "waste_report: can't read %s\n", argv[i]);
+			if (pFile)
+				std::fclose(pFile);
+			return 1;
+		}
+		std::fclose(pFile);
+	}
+
+	for (summary_map::const_iterator it = summaries.begin(); it != summaries.end(); ++it)
+		print_summary(it->first, it->second);
+
+	return 0;
+}